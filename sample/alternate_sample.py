@@ -0,0 +1,89 @@
+import time
+import thunsearch as thun
+
+
+class TicTacToeState(thun.BaseAlternateState):
+    LINES = [(0, 1, 2), (3, 4, 5), (6, 7, 8), (0, 3, 6),
+             (1, 4, 7), (2, 5, 8), (0, 4, 8), (2, 4, 6)]
+
+    def __init__(self) -> None:
+        super().__init__()
+        self.board_ = [0] * 9  # 1: player to move, -1: opponent
+        self.turn_ = 0
+
+    def winner(self):
+        for a, b, c in TicTacToeState.LINES:
+            if self.board_[a] != 0 and self.board_[a] == self.board_[b] == self.board_[c]:
+                return self.board_[a]
+        return 0
+
+    def is_done(self):
+        return self.winner() != 0 or self.turn_ == 9
+
+    def evaluate_score(self) -> float:
+        # the last mover is -1 after the board is flipped
+        return 100 * self.winner()
+
+    def advance(self, action):
+        self.board_[action] = 1
+        self.board_ = [-cell for cell in self.board_]
+        self.turn_ += 1
+
+    def legal_actions(self):
+        if self.winner() != 0:
+            return []
+        return [i for i in range(9) if self.board_[i] == 0]
+
+    def hash(self) -> int:
+        return hash(tuple(self.board_))
+
+    def __str__(self):
+        mark = {1: "x", -1: "o", 0: "."} if self.turn_ % 2 == 0 \
+            else {1: "o", -1: "x", 0: "."}
+        return "\n".join("".join(mark[self.board_[y * 3 + x]] for x in range(3))
+                         for y in range(3))
+
+
+def play_game(ai, *args):
+    state = TicTacToeState()
+    while not state.is_done():
+        state.advance(ai(state, *args))
+    print(state)
+    print("draw" if state.winner() == 0 else "winner decided")
+
+
+def play_game_with_session(session, playout_number):
+    """Reuse the search tree of the previous turn"""
+    state = TicTacToeState()
+    while not state.is_done():
+        action = session.search(state, playout_number)
+        state.advance(action)
+        session.advance(action)
+    print(state)
+    print("draw" if state.winner() == 0 else "winner decided")
+
+
+if __name__ == "__main__":
+    start_time = time.time()
+    play_game(thun.alpha_beta_action, 9)
+    print(f"alpha beta time:{round((time.time()-start_time)*1000)}ms")
+
+    start_time = time.time()
+    play_game(thun.mcts_action, 1000)
+    print(f"mcts time:{round((time.time()-start_time)*1000)}ms")
+
+    start_time = time.time()
+    play_game_with_session(thun.MctsSession(), 1000)
+    print(f"mcts session time:{round((time.time()-start_time)*1000)}ms")
+
+    start_time = time.time()
+    play_game(thun.parallel_mcts_action, 1000, 0, 2)
+    print(f"parallel mcts time:{round((time.time()-start_time)*1000)}ms")
+
+    start_time = time.time()
+    play_game(thun.parallel_mcts_action, 1000, 0, 2, thun.ParallelMode.Root)
+    print(f"root parallel mcts time:{round((time.time()-start_time)*1000)}ms")
+
+    start_time = time.time()
+    play_game(thun.thunder_search_action, 1000)
+    print(f"thunder time:{round((time.time()-start_time)*1000)}ms")
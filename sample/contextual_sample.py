@@ -136,3 +136,10 @@ if __name__ == "__main__":
 
     state = MazeState(0)
     thun.play_task(state, thun.beam_search_action, 2)
+
+    test_ai_performance(("beam 2", beam_py_function(2)), 100, 1)
+    test_ai_performance(
+        ("nmcs 1", lambda state: thun.nested_monte_carlo_action(state, 1)),
+        100, 1)
+    test_ai_performance(
+        ("nrpa 1", lambda state: thun.nrpa_action(state, 1, 20)), 100, 1)
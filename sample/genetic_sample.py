@@ -0,0 +1,42 @@
+import random
+import time
+import thunsearch as thun
+
+
+class PartitionIndividual(thun.BaseGeneticState):
+    """Split numbers into two groups whose sums are as close as possible"""
+    N = 40
+    NUMBERS = []
+
+    def __init__(self, sides) -> None:
+        super().__init__()
+        self.sides_ = sides
+
+    def crossover(self, other, rng):
+        point = rng.randrange(PartitionIndividual.N)
+        return PartitionIndividual(self.sides_[:point] + other.sides_[point:])
+
+    def mutate(self, rng):
+        self.sides_[rng.randrange(PartitionIndividual.N)] ^= 1
+
+    def evaluate_score(self) -> float:
+        diff = sum(n if side == 0 else -n
+                   for n, side in zip(PartitionIndividual.NUMBERS, self.sides_))
+        return -abs(diff)
+
+    def __str__(self):
+        return f"score:\t{self.evaluate_score()}\tsides:\t{self.sides_}"
+
+
+if __name__ == "__main__":
+    random.seed(0)
+    PartitionIndividual.NUMBERS = [random.randrange(1, 1000)
+                                   for _ in range(PartitionIndividual.N)]
+    population = [PartitionIndividual([random.randrange(2)
+                                       for _ in range(PartitionIndividual.N)])
+                  for _ in range(40)]
+
+    start_time = time.time()
+    best = thun.genetic_algorithm(population, 200, islands=4)
+    print("best", best)
+    print(f"time:{round((time.time()-start_time)*1000)}ms")
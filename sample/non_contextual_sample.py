@@ -0,0 +1,68 @@
+import random
+import time
+import thunsearch as thun
+
+
+class PartitionState(thun.BaseNonContextualState):
+    """Split numbers into two groups whose sums are as close as possible"""
+    N = 40
+
+    def __init__(self, seed=None) -> None:
+        super().__init__()
+        random.seed(seed)
+        self.numbers_ = [random.randrange(1, 1000)
+                         for _ in range(PartitionState.N)]
+        self.sides_ = [random.randrange(2) for _ in range(PartitionState.N)]
+        self.diff_ = sum(n if side == 0 else -n
+                         for n, side in zip(self.numbers_, self.sides_))
+
+    def neighbor(self, rng):
+        return rng.randrange(PartitionState.N)
+
+    def neighborhood(self):
+        return list(range(PartitionState.N))
+
+    def transition(self, move):
+        sign = 1 if self.sides_[move] == 0 else -1
+        self.diff_ -= 2 * sign * self.numbers_[move]
+        self.sides_[move] ^= 1
+
+    def evaluate_score(self) -> float:
+        return -abs(self.diff_)
+
+    def delta_score(self, move) -> float:
+        sign = 1 if self.sides_[move] == 0 else -1
+        return -abs(self.diff_ - 2 * sign * self.numbers_[move]) + abs(self.diff_)
+
+    def __str__(self):
+        return f"diff:\t{self.diff_}\tsides:\t{self.sides_}"
+
+
+if __name__ == "__main__":
+    print("not_implemented_must",
+          PartitionState.get_not_implemented_must_methods())
+    print("not_implemented_can",
+          PartitionState.get_not_implemented_can_methods())
+
+    state = PartitionState(0)
+    print("before", state)
+
+    start_time = time.time()
+    climbed = thun.hill_climb(state, 100000)
+    print("hill climbing      ", climbed)
+    print(f"time:{round((time.time()-start_time)*1000)}ms")
+
+    start_time = time.time()
+    annealed = thun.simulated_annealing(state, 500.0, 1.0, 1000)
+    print("simulated annealing", annealed)
+    print(f"time:{round((time.time()-start_time)*1000)}ms")
+
+    start_time = time.time()
+    tempered = thun.parallel_tempering(state, 500.0, 1.0, 1000, threads=4)
+    print("parallel tempering ", tempered)
+    print(f"time:{round((time.time()-start_time)*1000)}ms")
+
+    start_time = time.time()
+    tabu = thun.tabu_search(state, 1000)
+    print("tabu search        ", tabu)
+    print(f"time:{round((time.time()-start_time)*1000)}ms")
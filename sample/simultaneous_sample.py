@@ -0,0 +1,75 @@
+import random
+import time
+import thunsearch as thun
+
+
+class SimultaneousMazeState(thun.BaseSimultaneousState):
+    """Two characters collect points on the same maze at the same time"""
+    dy = [0, 0, 1, -1]  # 右、左、下、上への移動方向のy成分
+    dx = [1, -1, 0, 0]  # 右、左、下、上への移動方向のx成分
+    H = 3
+    W = 3
+    END_TURN = 4
+
+    def __init__(self, seed=None) -> None:
+        super().__init__()
+        random.seed(seed)
+        self.turn_ = 0
+        self.characters_ = [[0, 0], [SimultaneousMazeState.H - 1,
+                                     SimultaneousMazeState.W - 1]]
+        self.scores_ = [0, 0]
+        self.points_ = [[random.randrange(10)
+                         for w in range(SimultaneousMazeState.W)]
+                        for h in range(SimultaneousMazeState.H)]
+        for y, x in self.characters_:
+            self.points_[y][x] = 0
+
+    def is_done(self):
+        return self.turn_ == SimultaneousMazeState.END_TURN
+
+    def evaluate_score(self) -> float:
+        return self.scores_[0] - self.scores_[1]
+
+    def advance(self, action0, action1):
+        for player_id, action in enumerate((action0, action1)):
+            character = self.characters_[player_id]
+            character[0] += SimultaneousMazeState.dy[action]
+            character[1] += SimultaneousMazeState.dx[action]
+            self.scores_[player_id] += self.points_[character[0]][character[1]]
+        for y, x in self.characters_:
+            self.points_[y][x] = 0
+        self.turn_ += 1
+
+    def legal_actions(self, player_id):
+        y, x = self.characters_[player_id]
+        return [action for action in range(4)
+                if 0 <= y + SimultaneousMazeState.dy[action] < SimultaneousMazeState.H
+                and 0 <= x + SimultaneousMazeState.dx[action] < SimultaneousMazeState.W]
+
+    def __str__(self):
+        ss = f"turn:\t{self.turn_}\tscores:\t{self.scores_}\n"
+        for h in range(SimultaneousMazeState.H):
+            for w in range(SimultaneousMazeState.W):
+                if [h, w] == self.characters_[0]:
+                    ss += "A"
+                elif [h, w] == self.characters_[1]:
+                    ss += "B"
+                elif self.points_[h][w] > 0:
+                    ss += str(self.points_[h][w])
+                else:
+                    ss += "."
+            ss += "\n"
+        return ss
+
+
+if __name__ == "__main__":
+    state = SimultaneousMazeState(0)
+    print(state)
+    start_time = time.time()
+    while not state.is_done():
+        action0 = thun.duct_action(state, 0, 1000)
+        legal_actions1 = state.legal_actions(1)
+        action1 = legal_actions1[random.randrange(len(legal_actions1))]
+        state.advance(action0, action1)
+        print(state)
+    print(f"duct(A) vs random(B) time:{round((time.time()-start_time)*1000)}ms")
@@ -49,6 +49,7 @@ class CMakeBuild(build_ext):
             f"-DCMAKE_LIBRARY_OUTPUT_DIRECTORY={extdir}{os.sep}",
             f"-DPYTHON_EXECUTABLE={sys.executable}",
             f"-DCMAKE_BUILD_TYPE={cfg}",  # not used on MSVC, but no harm
+            "-DTHUNSEARCH_BUILD_BENCHMARK=OFF",
         ]
         build_args = []
         # Adding CMake arguments set as environment variable
@@ -141,6 +142,7 @@ setup(
     packages=find_packages(),
     cmdclass={"build_ext": CMakeBuild},
     zip_safe=False,
+    install_requires=["numpy"],
     extras_require={"test": ["pytest>=6.0"]},
     python_requires=">=3.7",
 )
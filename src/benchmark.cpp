@@ -0,0 +1,644 @@
+// Pythonを介さずに探索エンジンだけの速度を測るベンチマーク
+// 迷路・大きな盤面の収集ゲーム・ナップサック・スライドパズルをC++で実装し、
+// 各エンジンを幅や反復回数を変えて実行して、ノードあたりの時間・毎秒のノード数・状態のメモリ使用量を表示する
+// 使い方: thunsearch_benchmark [エンジン名の一部]
+#include "thunsearch.hpp"
+#include <array>
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+    // 計測中の数え上げ。並列探索からも更新されるのでatomicで持つ
+    struct BenchmarkCounter
+    {
+        std::atomic<long long> nodes{0};       // 状態を進めた回数、または評価した遷移の数
+        std::atomic<long long> live_states{0}; // 生存している状態数
+        std::atomic<long long> peak_states{0};
+        std::atomic<long long> live_bytes{0}; // 生存している状態が使うバイト数
+        std::atomic<long long> peak_bytes{0};
+
+        void resetPeak()
+        {
+            peak_states.store(live_states.load());
+            peak_bytes.store(live_bytes.load());
+        }
+    };
+
+    BenchmarkCounter &counter()
+    {
+        static BenchmarkCounter instance;
+        return instance;
+    }
+
+    void countNode() { counter().nodes.fetch_add(1, std::memory_order_relaxed); }
+
+    // 状態1つ分のバイト数(オブジェクト本体と状態だけが持つヒープ領域)を登録し、破棄するときに取り消す
+    class Footprint
+    {
+    private:
+        long long bytes_ = 0;
+
+        void add(const long long states, const long long bytes) const
+        {
+            auto &c = counter();
+            MemoryCounter::updateMax(c.peak_states, c.live_states.fetch_add(states, std::memory_order_relaxed) + states);
+            MemoryCounter::updateMax(c.peak_bytes, c.live_bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+        }
+
+    public:
+        Footprint() { add(1, 0); }
+        Footprint(const Footprint &other) : bytes_(other.bytes_) { add(1, bytes_); }
+        Footprint &operator=(const Footprint &other)
+        {
+            setBytes(other.bytes_);
+            return *this;
+        }
+        ~Footprint() { add(-1, -bytes_); }
+
+        void setBytes(const long long bytes)
+        {
+            add(0, bytes - bytes_);
+            bytes_ = bytes;
+        }
+    };
+
+    // 合法手を書き込む状態は_legal_actionsもそれで実装する
+    template <class State>
+    std::vector<int> legalActionsOf(State &state)
+    {
+        ActionBuffer buffer;
+        state.legal_actions_into(buffer);
+        return std::vector<int>(buffer.begin(), buffer.end());
+    }
+
+    constexpr int DY[4] = {0, 0, 1, -1}; // 右、左、下、上への移動方向のy成分
+    constexpr int DX[4] = {1, -1, 0, 0}; // 右、左、下、上への移動方向のx成分
+
+    // 盤面の点数と罠の位置。探索中は変わらないので全ての状態で共有する
+    struct GridBoard
+    {
+        int h;
+        int w;
+        int end_turn;
+        int start;
+        int trap; // 罠がなければ-1
+        std::vector<int> points;
+        std::vector<uint64_t> keys; // マスごとのZobristハッシュの値
+
+        GridBoard(const int h, const int w, const int end_turn, const bool has_trap, const uint64_t seed)
+            : h(h), w(w), end_turn(end_turn), trap(-1), points(h * w, 0), keys(h * w)
+        {
+            RandomGenerator rng(seed);
+            start = rng.randrange(h * w);
+            if (has_trap)
+            {
+                do
+                {
+                    trap = rng.randrange(h * w);
+                } while (trap == start);
+            }
+            for (int cell = 0; cell < h * w; cell++)
+            {
+                keys[cell] = mixHash(seed ^ (static_cast<uint64_t>(cell) << 32));
+                if (cell != start && cell != trap)
+                    points[cell] = rng.randrange(10);
+            }
+        }
+    };
+
+    // 盤面を動き回って点数を集める1人ゲーム。sampleの迷路と同じ規則で、大きさと手数を変えられる
+    // 取った点数のマスはビット列で持つので、複製しても盤面全体はコピーしない
+    class GridCollectorState : public ContextualState
+    {
+    private:
+        std::shared_ptr<const GridBoard> board_;
+        std::vector<uint64_t> collected_;
+        int position_;
+        int turn_ = 0;
+        int score_ = 0;
+        uint64_t collected_hash_ = 0;
+        Footprint footprint_;
+
+    public:
+        explicit GridCollectorState(std::shared_ptr<const GridBoard> board)
+            : board_(board), collected_((board->h * board->w + 63) / 64, 0), position_(board->start)
+        {
+            footprint_.setBytes(sizeof(*this) + collected_.capacity() * sizeof(uint64_t));
+        }
+
+        std::shared_ptr<ContextualState> clone() const override { return std::make_shared<GridCollectorState>(*this); }
+
+        void advance(const int action) override
+        {
+            countNode();
+            position_ += DY[action] * board_->w + DX[action];
+            const uint64_t bit = 1ULL << (position_ & 63);
+            auto &word = collected_[position_ >> 6];
+            if (board_->points[position_] > 0 && (word & bit) == 0)
+            {
+                score_ += board_->points[position_];
+                word |= bit;
+                collected_hash_ ^= board_->keys[position_];
+            }
+            turn_++;
+        }
+
+        void legal_actions_into(ActionBuffer &buffer) override
+        {
+            buffer.clear();
+            const int y = position_ / board_->w;
+            const int x = position_ % board_->w;
+            for (int action = 0; action < 4; action++)
+            {
+                const int ty = y + DY[action];
+                const int tx = x + DX[action];
+                if (ty >= 0 && ty < board_->h && tx >= 0 && tx < board_->w)
+                    buffer.push_back(action);
+            }
+        }
+        std::vector<int> _legal_actions() override { return legalActionsOf(*this); }
+
+        bool is_done() override { return turn_ == board_->end_turn; }
+        bool is_dead() override { return position_ == board_->trap; }
+        double evaluate_score() override { return score_; }
+        uint64_t hash() override { return mixHash(collected_hash_ + static_cast<uint64_t>(turn_) * board_->h * board_->w + position_); }
+        double heuristic() override { return board_->end_turn - turn_; }
+    };
+
+    // 品物の重さと価値
+    struct KnapsackItems
+    {
+        int capacity;
+        std::vector<int> weights;
+        std::vector<int> values;
+        std::vector<uint64_t> keys;
+        std::vector<int> by_density; // 価値/重さが大きい順の品物の番号
+
+        KnapsackItems(const int n, const uint64_t seed) : weights(n), values(n), keys(n)
+        {
+            RandomGenerator rng(seed);
+            int total_weight = 0;
+            for (int i = 0; i < n; i++)
+            {
+                weights[i] = 1 + rng.randrange(100);
+                values[i] = 1 + rng.randrange(100);
+                keys[i] = mixHash(seed ^ (static_cast<uint64_t>(i) << 32));
+                total_weight += weights[i];
+            }
+            capacity = total_weight / 3;
+            by_density.resize(n);
+            for (int i = 0; i < n; i++)
+                by_density[i] = i;
+            std::sort(by_density.begin(), by_density.end(), [&](const int a, const int b)
+                      { return values[a] * weights[b] > values[b] * weights[a]; });
+        }
+        int size() const { return static_cast<int>(weights.size()); }
+    };
+
+    // 品物を先頭から順に、入れる(1)か入れない(0)か決めていくナップサック問題
+    class KnapsackState : public ContextualState
+    {
+    private:
+        std::shared_ptr<const KnapsackItems> items_;
+        int index_ = 0;
+        int weight_ = 0;
+        int value_ = 0;
+        uint64_t taken_hash_ = 0;
+        Footprint footprint_;
+
+    public:
+        explicit KnapsackState(std::shared_ptr<const KnapsackItems> items) : items_(items) { footprint_.setBytes(sizeof(*this)); }
+
+        std::shared_ptr<ContextualState> clone() const override { return std::make_shared<KnapsackState>(*this); }
+
+        void advance(const int action) override
+        {
+            countNode();
+            if (action == 1)
+            {
+                weight_ += items_->weights[index_];
+                value_ += items_->values[index_];
+                taken_hash_ ^= items_->keys[index_];
+            }
+            index_++;
+        }
+
+        void legal_actions_into(ActionBuffer &buffer) override
+        {
+            buffer.clear();
+            if (index_ >= items_->size())
+                return;
+            buffer.reserve(2);
+            buffer.push_back(0);
+            if (weight_ + items_->weights[index_] <= items_->capacity)
+                buffer.push_back(1);
+        }
+        std::vector<int> _legal_actions() override { return legalActionsOf(*this); }
+
+        bool is_done() override { return index_ == items_->size(); }
+        bool is_dead() override { return false; }
+        double evaluate_score() override { return value_; }
+        uint64_t hash() override { return mixHash(taken_hash_ + index_); }
+
+        // 最良優先探索では入れなかった品物の価値をコストとして、失う価値が最小の選び方を探す
+        double step_cost(const int action) override { return action == 1 ? 0 : items_->values[index_]; }
+
+        // 残りの品物を分割して詰められるとしたときに、それでも入りきらない価値
+        double heuristic() override
+        {
+            double lost = 0;
+            double room = items_->capacity - weight_;
+            for (const int i : items_->by_density)
+            {
+                if (i < index_)
+                    continue;
+                const double fraction = std::min(1.0, room / items_->weights[i]);
+                room -= fraction * items_->weights[i];
+                lost += (1 - fraction) * items_->values[i];
+            }
+            return lost;
+        }
+    };
+
+    // 品物を入れるかどうかを1つずつ反転させる局所探索用のナップサック問題
+    // 容量を超えた分は重さ1あたりpenalty_だけ減点する
+    class KnapsackSelection : public NonContextualState
+    {
+    private:
+        std::shared_ptr<const KnapsackItems> items_;
+        std::vector<char> taken_;
+        int weight_ = 0;
+        int value_ = 0;
+        double penalty_ = 2.0;
+        Footprint footprint_;
+
+        double scoreOf(const int weight, const int value) const
+        {
+            return value - penalty_ * std::max(0, weight - items_->capacity);
+        }
+
+    public:
+        explicit KnapsackSelection(std::shared_ptr<const KnapsackItems> items) : items_(items), taken_(items->size(), 0)
+        {
+            footprint_.setBytes(sizeof(*this) + taken_.capacity());
+        }
+
+        std::shared_ptr<NonContextualState> clone() const override { return std::make_shared<KnapsackSelection>(*this); }
+
+        int neighbor(RandomGenerator &rng) override { return rng.randrange(items_->size()); }
+
+        void transition(const int move) override
+        {
+            const int sign = taken_[move] ? -1 : 1;
+            weight_ += sign * items_->weights[move];
+            value_ += sign * items_->values[move];
+            taken_[move] ^= 1;
+        }
+
+        double evaluate_score() override { return scoreOf(weight_, value_); }
+
+        bool has_delta_score() override { return true; }
+        double delta_score(const int move) override
+        {
+            countNode();
+            const int sign = taken_[move] ? -1 : 1;
+            return scoreOf(weight_ + sign * items_->weights[move], value_ + sign * items_->values[move]) - scoreOf(weight_, value_);
+        }
+
+        void neighborhood_into(ActionBuffer &buffer) override
+        {
+            buffer.clear();
+            for (int move = 0; move < items_->size(); move++)
+                buffer.push_back(move);
+        }
+        std::vector<int> _neighborhood() override
+        {
+            ActionBuffer buffer;
+            neighborhood_into(buffer);
+            return std::vector<int>(buffer.begin(), buffer.end());
+        }
+    };
+
+    // 遺伝的アルゴリズム用のナップサック問題。品物を入れるかどうかのビット列を個体とする
+    // 容量を超えた分はKnapsackSelectionと同じく重さ1あたりpenalty_だけ減点する
+    class KnapsackGenome : public GeneticState
+    {
+    private:
+        std::shared_ptr<const KnapsackItems> items_;
+        std::vector<char> taken_;
+        double penalty_ = 2.0;
+        Footprint footprint_;
+
+    public:
+        KnapsackGenome(std::shared_ptr<const KnapsackItems> items, RandomGenerator &rng) : items_(items), taken_(items->size(), 0)
+        {
+            for (auto &taken : taken_)
+                taken = rng.randrange(3) == 0;
+            footprint_.setBytes(sizeof(*this) + taken_.capacity());
+        }
+
+        std::shared_ptr<GeneticState> clone() const override { return std::make_shared<KnapsackGenome>(*this); }
+
+        // 一様交叉。品物ごとにどちらの親の選択を受け継ぐかを選ぶ
+        std::shared_ptr<GeneticState> crossover(const std::shared_ptr<GeneticState> &other, RandomGenerator &rng) override
+        {
+            const auto &partner = static_cast<const KnapsackGenome &>(*other);
+            auto child = std::make_shared<KnapsackGenome>(*this);
+            for (int i = 0; i < items_->size(); i++)
+                if (rng.randrange(2) == 1)
+                    child->taken_[i] = partner.taken_[i];
+            return child;
+        }
+
+        void mutate(RandomGenerator &rng) override { taken_[rng.randrange(items_->size())] ^= 1; }
+
+        double evaluate_score() override
+        {
+            countNode();
+            int weight = 0;
+            int value = 0;
+            for (int i = 0; i < items_->size(); i++)
+            {
+                if (!taken_[i])
+                    continue;
+                weight += items_->weights[i];
+                value += items_->values[i];
+            }
+            return value - penalty_ * std::max(0, weight - items_->capacity);
+        }
+    };
+
+    // 4x4のスライドパズル。行動は空きマスを動かす方向
+    // 各タイルのマンハッタン距離の和を残りコストの見積もりにする
+    class SlidingPuzzleState : public ContextualState
+    {
+    private:
+        static constexpr int N = 4;
+        std::array<uint8_t, N * N> tiles_;
+        int blank_ = 0;
+        int turn_ = 0;
+        int max_turns_;
+        int distance_ = 0;
+        uint64_t hash_ = 0;
+        Footprint footprint_;
+
+        static uint64_t key(const int tile, const int cell) { return mixHash(static_cast<uint64_t>(tile * N * N + cell + 1)); }
+        static int distance(const int tile, const int cell)
+        {
+            return tile == 0 ? 0 : std::abs(tile / N - cell / N) + std::abs(tile % N - cell % N);
+        }
+
+        void move(const int action)
+        {
+            const int target = blank_ + DY[action] * N + DX[action];
+            const int tile = tiles_[target];
+            distance_ += distance(tile, blank_) - distance(tile, target);
+            hash_ ^= key(tile, target) ^ key(tile, blank_) ^ key(0, blank_) ^ key(0, target);
+            tiles_[blank_] = static_cast<uint8_t>(tile);
+            tiles_[target] = 0;
+            blank_ = target;
+        }
+
+    public:
+        // 完成形から空きマスをscramble回ランダムに動かした盤面をつくる
+        SlidingPuzzleState(const int scramble, const int max_turns, const uint64_t seed) : max_turns_(max_turns)
+        {
+            footprint_.setBytes(sizeof(*this));
+            for (int cell = 0; cell < N * N; cell++)
+            {
+                tiles_[cell] = static_cast<uint8_t>(cell);
+                hash_ ^= key(cell, cell);
+            }
+            RandomGenerator rng(seed);
+            ActionBuffer actions;
+            for (int i = 0; i < scramble; i++)
+            {
+                legal_actions_into(actions);
+                move(actions[rng.randrange(static_cast<int>(actions.size()))]);
+            }
+        }
+
+        std::shared_ptr<ContextualState> clone() const override { return std::make_shared<SlidingPuzzleState>(*this); }
+
+        void advance(const int action) override
+        {
+            countNode();
+            move(action);
+            turn_++;
+        }
+
+        void legal_actions_into(ActionBuffer &buffer) override
+        {
+            buffer.clear();
+            const int y = blank_ / N;
+            const int x = blank_ % N;
+            for (int action = 0; action < 4; action++)
+            {
+                const int ty = y + DY[action];
+                const int tx = x + DX[action];
+                if (ty >= 0 && ty < N && tx >= 0 && tx < N)
+                    buffer.push_back(action);
+            }
+        }
+        std::vector<int> _legal_actions() override { return legalActionsOf(*this); }
+
+        bool is_done() override { return distance_ == 0 || turn_ == max_turns_; }
+        bool is_dead() override { return false; }
+        double evaluate_score() override { return -distance_; }
+        uint64_t hash() override { return hash_; }
+        double heuristic() override { return distance_; }
+    };
+
+    // 1行分の計測結果
+    struct Sample
+    {
+        double score = 0;
+    };
+
+    constexpr int64_t TIME_LIMIT = 100;     // 時間で打ち切るエンジンに渡す制限時間(ms)
+    constexpr double MIN_MEASURE_MS = 50.0; // 短く終わる探索はこの時間を超えるまで繰り返す
+
+    const char *filter = nullptr;
+
+    // runを繰り返し実行して1行表示する
+    template <class Run>
+    void measure(const char *engine, const char *problem, const std::string &param, Run &&run)
+    {
+        if (filter != nullptr && std::strstr(engine, filter) == nullptr)
+            return;
+        auto &c = counter();
+        c.nodes.store(0);
+        c.resetPeak();
+        const long long base_states = c.live_states.load();
+        const long long base_bytes = c.live_bytes.load();
+        Sample sample;
+        int runs = 0;
+        double elapsed_ms = 0;
+        const auto start = std::chrono::steady_clock::now();
+        while (runs == 0 || elapsed_ms < MIN_MEASURE_MS)
+        {
+            run(sample);
+            runs++;
+            elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+        const double nodes = static_cast<double>(c.nodes.load()) / runs;
+        const double ms = elapsed_ms / runs;
+        std::printf("%-20s %-10s %-14s %12.0f %10.3f %10.1f %12.0f %12lld %10.1f %12.1f\n",
+                    engine, problem, param.c_str(), nodes, ms,
+                    nodes > 0 ? ms * 1e6 / nodes : 0.0,
+                    ms > 0 ? nodes * 1e3 / ms : 0.0,
+                    c.peak_states.load() - base_states,
+                    static_cast<double>(c.peak_bytes.load() - base_bytes) / 1024.0,
+                    sample.score);
+        std::fflush(stdout);
+    }
+
+    // 終了状態まで行動列を適用した評価値
+    double scoreAfter(const std::shared_ptr<ContextualState> &root, const std::vector<int> &actions)
+    {
+        auto state = root->clone();
+        for (const int action : actions)
+            state->advance(action);
+        return state->evaluate_score();
+    }
+
+    void benchmarkContextual(const char *problem, const std::function<std::shared_ptr<ContextualState>()> &make_root)
+    {
+        for (const int width : {1, 10, 100, 1000})
+        {
+            measure("beam_search", problem, "width=" + std::to_string(width), [&](Sample &sample)
+                    {
+                        SearchResult result;
+                        beamSearchAction(make_root(), width, nullptr, nullptr, &result);
+                        sample.score = result.score; });
+        }
+        for (const int width : {10, 100})
+        {
+            measure("beam_stack_search", problem, "width=" + std::to_string(width), [&](Sample &sample)
+                    {
+                        SearchResult result;
+                        beamStackSearchAction(make_root(), width, TIME_LIMIT, nullptr, nullptr, &result);
+                        sample.score = result.score; });
+        }
+        for (const int width : {10, 100, 1000})
+        {
+            // 2手分の探索で、2手目は1手目の探索を引き継ぐ
+            measure("search_session", problem, "width=" + std::to_string(width), [&](Sample &sample)
+                    {
+                        SearchSession session(width, 1 << 16, 4);
+                        auto root = make_root();
+                        auto actions = session.search(root, nullptr);
+                        if (actions.empty())
+                            return;
+                        auto next_root = root->clone();
+                        next_root->advance(actions[0]);
+                        SearchResult result;
+                        session.search(next_root, &result);
+                        sample.score = result.score; });
+        }
+        for (const double weight : {1.0, 2.0})
+        {
+            measure("best_first", problem, "weight=" + std::to_string(weight).substr(0, 3), [&](Sample &sample)
+                    {
+                        auto root = make_root();
+                        sample.score = scoreAfter(root, bestFirstAction(root, weight, 100000, TIME_LIMIT)); });
+        }
+        for (const int level : {1, 2})
+        {
+            measure("nested_monte_carlo", problem, "level=" + std::to_string(level), [&](Sample &sample)
+                    {
+                        auto root = make_root();
+                        sample.score = scoreAfter(root, nestedMonteCarloAction(root, level, TIME_LIMIT, 0, {})); });
+        }
+        for (const int level : {1, 2})
+        {
+            measure("nrpa", problem, "level=" + std::to_string(level), [&](Sample &sample)
+                    {
+                        auto root = make_root();
+                        sample.score = scoreAfter(root, nrpaAction(root, level, 100, 1.0, TIME_LIMIT, 0)); });
+        }
+        for (const int threads : {1, 4})
+        {
+            measure("random_rollouts", problem, "n=1000,t=" + std::to_string(threads), [&](Sample &sample)
+                    {
+                        const auto batch = randomRollouts(make_root(), 1000, threads, 0, false, {});
+                        sample.score = *std::max_element(batch.scores.begin(), batch.scores.end()); });
+        }
+    }
+
+    void benchmarkNonContextual(const char *problem, const std::function<std::shared_ptr<NonContextualState>()> &make_state)
+    {
+        for (const int64_t iterations : {10000, 100000, 1000000})
+        {
+            measure("hill_climb", problem, "iter=" + std::to_string(iterations), [&](Sample &sample)
+                    { sample.score = hillClimb(make_state(), iterations, 0, 0)->evaluated_score_; });
+        }
+        for (const int64_t iterations : {10000, 100000, 1000000})
+        {
+            const auto schedule = makeTemperatureSchedule(TemperatureSchedule::Exponential, 100, 1);
+            measure("simulated_annealing", problem, "iter=" + std::to_string(iterations), [&](Sample &sample)
+                    { sample.score = simulatedAnnealing(make_state(), schedule, 0, iterations, 100, 0)->evaluated_score_; });
+        }
+        for (const int64_t iterations : {100, 1000})
+        {
+            measure("tabu_search", problem, "iter=" + std::to_string(iterations), [&](Sample &sample)
+                    { sample.score = tabuSearch(make_state(), iterations, 0, 7)->evaluated_score_; });
+        }
+        for (const int threads : {1, 2, 4})
+        {
+            measure("parallel_tempering", problem, "t=" + std::to_string(threads), [&](Sample &sample)
+                    { sample.score = parallelTempering(make_state(), 100, 1, 0, 100000, threads, 100, 0)->evaluated_score_; });
+        }
+    }
+
+    void benchmarkGenetic(const char *problem, const std::function<std::shared_ptr<GeneticState>(RandomGenerator &)> &make_individual)
+    {
+        for (const int threads : {1, 4})
+        {
+            measure("genetic_algorithm", problem, "gen=100,t=" + std::to_string(threads), [&](Sample &sample)
+                    {
+                        RandomGenerator rng(0);
+                        std::vector<std::shared_ptr<GeneticState>> population;
+                        for (int i = 0; i < 100; i++)
+                            population.emplace_back(make_individual(rng));
+                        GeneticConfig config;
+                        config.generations = 100;
+                        config.islands = 4;
+                        config.threads = threads;
+                        sample.score = geneticAlgorithm(population, config)->evaluated_score_; });
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1)
+        filter = argv[1];
+
+    std::printf("%-20s %-10s %-14s %12s %10s %10s %12s %12s %10s %12s\n",
+                "engine", "problem", "param", "nodes", "ms", "ns/node", "nodes/sec", "peak_states", "peak_KiB", "score");
+
+    // sampleの迷路と同じ大きさ
+    const auto maze = std::make_shared<const GridBoard>(3, 4, 4, true, 0);
+    benchmarkContextual("maze", [&]
+                        { return std::make_shared<GridCollectorState>(maze); });
+
+    const auto grid = std::make_shared<const GridBoard>(30, 30, 100, false, 0);
+    benchmarkContextual("collector", [&]
+                        { return std::make_shared<GridCollectorState>(grid); });
+
+    const auto items = std::make_shared<const KnapsackItems>(100, 0);
+    benchmarkContextual("knapsack", [&]
+                        { return std::make_shared<KnapsackState>(items); });
+
+    benchmarkContextual("puzzle", []
+                        { return std::make_shared<SlidingPuzzleState>(40, 80, 0); });
+
+    benchmarkNonContextual("knapsack", [&]
+                           { return std::make_shared<KnapsackSelection>(items); });
+
+    benchmarkGenetic("knapsack", [&](RandomGenerator &rng)
+                     { return std::make_shared<KnapsackGenome>(items, rng); });
+    return 0;
+}
@@ -1,57 +1,141 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/stl_bind.h>
-#include <random>
-#include <memory>
-#include <algorithm>
-#include <iostream>
-#include <queue>
+#include <pybind11/functional.h>
+#include <pybind11/stl.h>
+#include <pybind11/numpy.h>
+#include "thunsearch.hpp"
 namespace py = pybind11;
+PYBIND11_MAKE_OPAQUE(std::vector<int>);
 #define STRINGIFY(x) #x
 #define MACRO_STRINGIFY(x) STRINGIFY(x)
-std::mt19937 mt_for_action(0); // 行動選択用の乱数生成器を初期化
-using std::cerr;
-using std::cout;
-using std::endl;
 
-class ContextualState : public std::enable_shared_from_this<ContextualState>
+// Pythonから受け取る乱数の種。整数ならその値を使い、Noneなら呼び出しごとに新しい種を引く
+struct Seed
 {
-public:
-    std::shared_ptr<ContextualState> parent_ = nullptr;
-    double evaluated_score_ = 0; // 探索上で評価したスコア
-    int last_action_ = -1;       // 直前に選択した行動
+    uint64_t value = 0;
+    operator uint64_t() const { return value; }
+};
 
-    virtual ~ContextualState() {}
-    virtual std::shared_ptr<ContextualState> clone() const = 0;
-    virtual void advance(const int action) = 0;
-    virtual std::vector<int> _legal_actions() = 0;
+// Noneを渡されたときの種。モジュールで1つの乱数列から引くので、呼ぶたびに異なる種になる
+// 引数の変換はGILを持って行われるので排他は要らない
+inline uint64_t freshSeed()
+{
+    static RandomGenerator generator(std::random_device{}() ^
+                                     static_cast<uint64_t>(std::chrono::high_resolution_clock::now().time_since_epoch().count()));
+    const uint64_t high = generator.next();
+    return (high << 32) | generator.next();
+}
 
-    // ゲームの終了判定
-    virtual bool is_done() = 0;
+namespace pybind11
+{
+    namespace detail
+    {
+        template <>
+        struct type_caster<Seed>
+        {
+        public:
+            PYBIND11_TYPE_CASTER(Seed, _("Optional[int]"));
 
-    virtual bool is_dead() = 0;
+            bool load(handle src, bool convert)
+            {
+                if (src.is_none())
+                {
+                    value.value = freshSeed();
+                    return true;
+                }
+                type_caster<uint64_t> integer;
+                if (!integer.load(src, convert))
+                    return false;
+                value.value = static_cast<uint64_t>(integer);
+                return true;
+            }
 
-    // 探索用の盤面評価をする
-    virtual double evaluate_score() = 0;
+            static handle cast(const Seed &seed, return_value_policy, handle) { return PyLong_FromUnsignedLongLong(seed.value); }
+        };
+    }
+}
+
+// 探索関数の引数のうちuint64_tの種をSeedに置き換えて、Noneも受け取れるようにする
+template <class T>
+struct SeedParameter
+{
+    using type = T;
+};
+template <>
+struct SeedParameter<uint64_t>
+{
+    using type = Seed;
+};
+
+template <class Return, class... Args>
+std::function<Return(typename SeedParameter<Args>::type...)> seeded(Return (*function)(Args...))
+{
+    return [function](typename SeedParameter<Args>::type... args)
+    { return function(args...); };
+}
 
-    std::shared_ptr<ContextualState> cloneAdvanced(int action)
+// Python側でつくった状態を、Pythonオブジェクトの寿命と連動するshared_ptrとして受け取る
+template <class State, class PyState>
+std::shared_ptr<State> adoptPythonState(py::object object)
+{
+    auto ptr = object.template cast<PyState *>();
+
+    // 並列探索ではGILを持たないスレッドで最後の参照が消えることがあるので、解放時にGILを取得する
+    auto keep_python_state_alive = std::shared_ptr<py::object>(
+        new py::object(std::move(object)),
+        [](py::object *kept)
+        {
+            py::gil_scoped_acquire gil;
+            delete kept;
+        });
+
+    // aliasing shared_ptr: points to `A_trampoline* ptr` but refcounts the Python object
+    return std::shared_ptr<State>(keep_python_state_alive, ptr);
+}
+
+// Python側の整数列を返すメソッド(_legal_actionsなど)を呼び、戻り値を中間のstd::vectorを作らずにバッファへ写す
+// argsはメソッドにそのまま渡す
+template <class State, class... Args>
+void pythonIntsInto(const State *self, const char *name, ActionBuffer &buffer, Args &&...args)
+{
+    py::gil_scoped_acquire gil;
+    py::function override = py::get_override(self, name);
+    if (!override)
+        py::pybind11_fail("Tried to call pure virtual function \"" + std::string(name) + "\"");
+    py::object result = override(std::forward<Args>(args)...);
+    if (py::isinstance<std::vector<int>>(result))
     {
-        auto clone = this->clone();
-        auto actions = clone->_legal_actions();
-        clone->advance(action);
-        clone->parent_ = shared_from_this();
-        clone->last_action_ = action;
-        return clone;
+        const auto &actions = result.cast<const std::vector<int> &>();
+        buffer.assign(actions.begin(), actions.end());
+        return;
     }
-};
+    buffer.clear();
+    for (const auto &action : result)
+        buffer.push_back(action.cast<int>());
+}
 
-// 探索時のソート用に評価を比較する
-bool operator<(const ContextualState &state_1, const ContextualState &state_2)
+// Python側のhash()などを呼び、値を64bitの符号なし整数として受け取る
+// Pythonのhash()は負の値も返すので、下位64bitをそのまま使う
+template <class State, class... Args>
+uint64_t pythonUint64(const State *self, const char *name, Args &&...args)
 {
-    return state_1.evaluated_score_ < state_2.evaluated_score_;
+    py::gil_scoped_acquire gil;
+    py::function override = py::get_override(self, name);
+    if (!override)
+        py::pybind11_fail("Tried to call pure virtual function \"" + std::string(name) + "\"");
+    py::object result = override(std::forward<Args>(args)...);
+    const uint64_t value = PyLong_AsUnsignedLongLongMask(result.ptr());
+    if (PyErr_Occurred())
+        throw py::error_already_set();
+    return value;
 }
-bool operator<(const std::shared_ptr<ContextualState> &state_1, const std::shared_ptr<ContextualState> &state_2)
+
+// Python側のclone()で複製した状態を受け取る
+template <class State, class PyState>
+std::shared_ptr<State> clonePythonState(const PyState *self)
 {
-    return state_1->evaluated_score_ < state_2->evaluated_score_;
+    py::gil_scoped_acquire gil;
+    return adoptPythonState<State, PyState>(py::cast(self).attr("clone")());
 }
 
 class PyContextualState : public ContextualState
@@ -63,14 +147,7 @@ public:
     /* Trampoline (need one for each virtual function) */
     std::shared_ptr<ContextualState> clone() const override
     {
-        auto self = py::cast(this);
-        auto cloned = self.attr("clone")();
-
-        auto keep_python_state_alive = std::make_shared<py::object>(cloned);
-        auto ptr = cloned.cast<PyContextualState *>();
-
-        // aliasing shared_ptr: points to `A_trampoline* ptr` but refcounts the Python object
-        return std::shared_ptr<ContextualState>(keep_python_state_alive, ptr);
+        return clonePythonState<ContextualState>(this);
     }
 
     void advance(int action) override
@@ -82,6 +159,12 @@ public:
         PYBIND11_OVERRIDE_PURE(/* Return type */ std::vector<int>, /* Parent class */ ContextualState, /* Name of function */ _legal_actions);
     }
 
+    // Python側の_legal_actionsの戻り値を中間のstd::vectorを作らずにバッファへ写す
+    void legal_actions_into(ActionBuffer &buffer) override
+    {
+        pythonIntsInto<ContextualState>(this, "_legal_actions", buffer);
+    }
+
     bool is_dead() override
     {
         PYBIND11_OVERRIDE_PURE(/* Return type */ bool, /* Parent class */ ContextualState, /* Name of function */ is_dead);
@@ -96,105 +179,300 @@ public:
     {
         PYBIND11_OVERRIDE_PURE(/* Return type */ double, /* Parent class */ ContextualState, /* Name of function */ evaluate_score);
     }
+
+    uint64_t hash() override
+    {
+        return pythonUint64<ContextualState>(this, "hash");
+    }
+
+    double step_cost(int action) override
+    {
+        PYBIND11_OVERRIDE(/* Return type */ double, /* Parent class */ ContextualState, /* Name of function */ step_cost, /* args */ action);
+    }
+
+    double heuristic() override
+    {
+        PYBIND11_OVERRIDE(/* Return type */ double, /* Parent class */ ContextualState, /* Name of function */ heuristic);
+    }
+
+    // Python側のaction_weightsがNoneを返したら重みなしとする
+    bool action_weights_into(std::vector<double> &weights) override
+    {
+        py::gil_scoped_acquire gil;
+        py::function override = py::get_override(this, "action_weights");
+        if (!override)
+            return false;
+        py::object result = override();
+        if (result.is_none())
+            return false;
+        weights.clear();
+        for (const auto &weight : result)
+            weights.push_back(weight.cast<double>());
+        return true;
+    }
+
+    // Python側のstepの(子, 評価値, 終了したか, 合法でないか)を受け取る
+    // 子1つにつきPythonを1回呼ぶだけで済む
+    // 基底クラスの既定のstepは実装されていないものとして扱い、呼び出し側で個別に呼ばせる
+    bool step_into(const int action, StepResult &result) override
+    {
+        py::gil_scoped_acquire gil;
+        py::function override = py::get_override(this, "step");
+        if (!override || py::hasattr(override, "__default_step__"))
+            return false;
+        const py::tuple stepped = override(action);
+        if (stepped.size() != 4)
+            throw std::invalid_argument("step must return (state, score, done, dead)");
+        result.state = adoptPythonState<ContextualState, PyContextualState>(stepped[0]);
+        result.score = stepped[1].cast<double>();
+        result.done = stepped[2].cast<bool>();
+        result.dead = stepped[3].cast<bool>();
+        return true;
+    }
 };
 
-// ランダムに行動を決定する
-std::vector<int> randomAction(std::shared_ptr<ContextualState> state)
+class PyNonContextualState : public NonContextualState
 {
-    using namespace std;
-    while (!state->is_done() && !state->is_dead())
+public:
+    /* Inherit the constructors */
+    using NonContextualState::NonContextualState;
+    PyNonContextualState(const NonContextualState &state) : NonContextualState(state) {}
+    /* Trampoline (need one for each virtual function) */
+    std::shared_ptr<NonContextualState> clone() const override
     {
-        auto legal_actions = state->_legal_actions();
+        return clonePythonState<NonContextualState>(this);
+    }
 
-        int action = legal_actions[mt_for_action() % (legal_actions.size())];
-        state = state->cloneAdvanced(action);
+    int neighbor(RandomGenerator &rng) override
+    {
+        // 参照で渡すとコピーされてしまうので、ポインタで渡して同じ乱数生成器を使わせる
+        PYBIND11_OVERRIDE_PURE(/* Return type */ int, /* Parent class */ NonContextualState, /* Name of function */ neighbor, /* args */ &rng);
     }
-    std::vector<int> actions{};
-    while (state->parent_ != nullptr)
+
+    void transition(int move) override
     {
-        actions.emplace_back(state->last_action_);
-        state = state->parent_;
+        PYBIND11_OVERRIDE_PURE(/* Return type */ void, /* Parent class */ NonContextualState, /* Name of function */ transition, /* args */ move);
+    }
+
+    double evaluate_score() override
+    {
+        PYBIND11_OVERRIDE_PURE(/* Return type */ double, /* Parent class */ NonContextualState, /* Name of function */ evaluate_score);
+    }
+
+    bool has_delta_score() override
+    {
+        PYBIND11_OVERRIDE(/* Return type */ bool, /* Parent class */ NonContextualState, /* Name of function */ has_delta_score);
+    }
+
+    double delta_score(int move) override
+    {
+        PYBIND11_OVERRIDE(/* Return type */ double, /* Parent class */ NonContextualState, /* Name of function */ delta_score, /* args */ move);
+    }
+
+    std::vector<int> _neighborhood() override
+    {
+        PYBIND11_OVERRIDE(/* Return type */ std::vector<int>, /* Parent class */ NonContextualState, /* Name of function */ _neighborhood);
+    }
+
+    void neighborhood_into(ActionBuffer &buffer) override
+    {
+        pythonIntsInto<NonContextualState>(this, "_neighborhood", buffer);
+    }
+
+    uint64_t move_attribute(int move) override
+    {
+        return pythonUint64<NonContextualState>(this, "move_attribute", move);
+    }
+};
+
+class PyGeneticState : public GeneticState
+{
+public:
+    /* Inherit the constructors */
+    using GeneticState::GeneticState;
+    PyGeneticState(const GeneticState &state) : GeneticState(state) {}
+    /* Trampoline (need one for each virtual function) */
+    std::shared_ptr<GeneticState> clone() const override
+    {
+        return clonePythonState<GeneticState>(this);
     }
-    std::reverse(actions.begin(), actions.end());
-    return actions;
-}
 
-// ビーム幅を指定してビームサーチで行動を決定する
-std::vector<int> beamSearchAction(std::shared_ptr<ContextualState> state, const int beam_width)
+    std::shared_ptr<GeneticState> crossover(const std::shared_ptr<GeneticState> &other, RandomGenerator &rng) override
+    {
+        // 戻り値のPythonオブジェクトごと保持しないと、Python側の属性が先に解放されてしまう
+        py::gil_scoped_acquire gil;
+        py::function override = py::get_override(static_cast<const GeneticState *>(this), "crossover");
+        if (!override)
+            py::pybind11_fail("Tried to call pure virtual function \"GeneticState::crossover\"");
+        return adoptPythonState<GeneticState, PyGeneticState>(override(other, &rng));
+    }
+
+    void mutate(RandomGenerator &rng) override
+    {
+        PYBIND11_OVERRIDE_PURE(/* Return type */ void, /* Parent class */ GeneticState, /* Name of function */ mutate, /* args */ &rng);
+    }
+
+    double evaluate_score() override
+    {
+        PYBIND11_OVERRIDE_PURE(/* Return type */ double, /* Parent class */ GeneticState, /* Name of function */ evaluate_score);
+    }
+};
+
+class PyAlternateState : public AlternateState
 {
-    using ContextualStatePtr = std::shared_ptr<ContextualState>;
-    std::priority_queue<ContextualStatePtr, std::vector<ContextualStatePtr>, std::greater<ContextualStatePtr>> now_beam;
-    std::shared_ptr<ContextualState> best_state = nullptr;
+public:
+    /* Inherit the constructors */
+    using AlternateState::AlternateState;
+    PyAlternateState(const AlternateState &state) : AlternateState(state) {}
+    /* Trampoline (need one for each virtual function) */
+    std::shared_ptr<AlternateState> clone() const override
+    {
+        return clonePythonState<AlternateState>(this);
+    }
 
-    now_beam.emplace(state);
-    for (int t = 0;; t++)
+    void advance(int action) override
     {
-        std::priority_queue<ContextualStatePtr, std::vector<ContextualStatePtr>, std::greater<ContextualStatePtr>> next_beam;
+        PYBIND11_OVERRIDE_PURE(/* Return type */ void, /* Parent class */ AlternateState, /* Name of function */ advance, /* args */ action);
+    }
 
-        for (int i = 0; i < beam_width; i++)
-        {
-            if (now_beam.empty())
-                break;
-            std::shared_ptr<ContextualState> now_state = now_beam.top();
-            // cout << "t " << t << "\tnow_score:" << now_state->evaluated_score_ << endl;
-
-            now_beam.pop();
-            auto legal_actions = now_state->_legal_actions();
-            for (const auto &action : legal_actions)
-            {
-                auto next_state = now_state->cloneAdvanced(action);
-                if (next_state->is_dead())
-                {
-                    continue;
-                }
-                next_state->evaluated_score_ = next_state->evaluate_score();
+    std::vector<int> _legal_actions() override
+    {
+        PYBIND11_OVERRIDE_PURE(/* Return type */ std::vector<int>, /* Parent class */ AlternateState, /* Name of function */ _legal_actions);
+    }
 
-                if (next_beam.size() >= beam_width && next_beam.top()->evaluated_score_ >= next_state->evaluated_score_)
-                {
-                    continue;
-                }
+    void legal_actions_into(ActionBuffer &buffer) override
+    {
+        pythonIntsInto<AlternateState>(this, "_legal_actions", buffer);
+    }
 
-                assert(next_state->parent_ != nullptr);
+    bool is_done() override
+    {
+        PYBIND11_OVERRIDE_PURE(/* Return type */ bool, /* Parent class */ AlternateState, /* Name of function */ is_done);
+    }
 
-                if (next_state->is_done())
-                {
-                    if (best_state == nullptr || next_state > best_state)
-                    {
-                        best_state = next_state;
-                    }
-                    continue;
-                }
+    double evaluate_score() override
+    {
+        PYBIND11_OVERRIDE_PURE(/* Return type */ double, /* Parent class */ AlternateState, /* Name of function */ evaluate_score);
+    }
 
-                // cout << "next_state " << next_state->evaluated_score_ << endl;
-                next_beam.emplace(next_state);
-                if (next_beam.size() > beam_width)
-                {
-                    next_beam.pop();
-                }
-            }
-        }
+    uint64_t hash() override
+    {
+        return pythonUint64<AlternateState>(this, "hash");
+    }
+};
 
-        if (best_state != nullptr)
-        {
-            break;
-        }
-        now_beam = next_beam;
+class PySimultaneousState : public SimultaneousState
+{
+public:
+    /* Inherit the constructors */
+    using SimultaneousState::SimultaneousState;
+    PySimultaneousState(const SimultaneousState &state) : SimultaneousState(state) {}
+    /* Trampoline (need one for each virtual function) */
+    std::shared_ptr<SimultaneousState> clone() const override
+    {
+        return clonePythonState<SimultaneousState>(this);
     }
 
-    std::vector<int> actions{};
-    while (best_state->parent_ != nullptr)
+    void advance(int action0, int action1) override
     {
-        actions.emplace_back(best_state->last_action_);
-        best_state = best_state->parent_;
+        PYBIND11_OVERRIDE_PURE(/* Return type */ void, /* Parent class */ SimultaneousState, /* Name of function */ advance, /* args */ action0, action1);
     }
-    std::reverse(actions.begin(), actions.end());
-    return actions;
-}
+
+    std::vector<int> _legal_actions(int player_id) override
+    {
+        PYBIND11_OVERRIDE_PURE(/* Return type */ std::vector<int>, /* Parent class */ SimultaneousState, /* Name of function */ _legal_actions, /* args */ player_id);
+    }
+
+    void legal_actions_into(int player_id, ActionBuffer &buffer) override
+    {
+        pythonIntsInto<SimultaneousState>(this, "_legal_actions", buffer, player_id);
+    }
+
+    bool is_done() override
+    {
+        PYBIND11_OVERRIDE_PURE(/* Return type */ bool, /* Parent class */ SimultaneousState, /* Name of function */ is_done);
+    }
+
+    double evaluate_score() override
+    {
+        PYBIND11_OVERRIDE_PURE(/* Return type */ double, /* Parent class */ SimultaneousState, /* Name of function */ evaluate_score);
+    }
+};
 
 PYBIND11_MODULE(_thunsearch, m)
 {
     py::bind_vector<std::vector<int>>(m, "VectorInt");
 
+    py::class_<SearchMemoryStats>(m, "SearchMemoryStats")
+        .def(py::init<>())
+        .def_readonly("live_states", &SearchMemoryStats::live_states)
+        .def_readonly("peak_live_states", &SearchMemoryStats::peak_live_states)
+        .def_readonly("total_clones", &SearchMemoryStats::total_clones)
+        .def_readonly("bytes_allocated", &SearchMemoryStats::bytes_allocated)
+        .def_readonly("peak_ancestor_states", &SearchMemoryStats::peak_ancestor_states)
+        .def("__repr__", [](const SearchMemoryStats &stats)
+             { return "SearchMemoryStats(live_states=" + std::to_string(stats.live_states) +
+                      ", peak_live_states=" + std::to_string(stats.peak_live_states) +
+                      ", total_clones=" + std::to_string(stats.total_clones) +
+                      ", bytes_allocated=" + std::to_string(stats.bytes_allocated) +
+                      ", peak_ancestor_states=" + std::to_string(stats.peak_ancestor_states) + ")"; });
+
+    py::class_<Tracer>(m, "Tracer")
+        .def(py::init<std::size_t>(), py::arg("capacity") = 1 << 16)
+        .def("start", &Tracer::start)
+        .def("stop", &Tracer::stop)
+        .def("__enter__", [](Tracer &tracer) -> Tracer &
+             { tracer.start(); return tracer; }, py::return_value_policy::reference)
+        .def("__exit__", [](Tracer &tracer, py::object, py::object, py::object)
+             { tracer.stop(); })
+        .def("dump", &Tracer::dump, py::arg("path"))
+        .def_property_readonly("event_count", &Tracer::eventCount)
+        .def_property_readonly("dropped_events", &Tracer::droppedEvents);
+
+    py::class_<SearchResult>(m, "SearchResult")
+        .def(py::init<>())
+        .def_readonly("actions", &SearchResult::actions)
+        .def_readonly("score", &SearchResult::score)
+        .def_readonly("nodes_expanded", &SearchResult::nodes_expanded)
+        .def_readonly("clones", &SearchResult::clones)
+        .def_readonly("pruned_dead", &SearchResult::pruned_dead)
+        .def_readonly("pruned_beam", &SearchResult::pruned_beam)
+        .def_readonly("pruned_duplicate", &SearchResult::pruned_duplicate)
+        .def_readonly("depth", &SearchResult::depth)
+        .def_readonly("callback_ms", &SearchResult::callback_ms)
+        .def_readonly("engine_ms", &SearchResult::engine_ms)
+        .def("__repr__", [](const SearchResult &result)
+             { return "SearchResult(score=" + std::to_string(result.score) +
+                      ", depth=" + std::to_string(result.depth) +
+                      ", nodes_expanded=" + std::to_string(result.nodes_expanded) +
+                      ", clones=" + std::to_string(result.clones) +
+                      ", pruned_dead=" + std::to_string(result.pruned_dead) +
+                      ", pruned_beam=" + std::to_string(result.pruned_beam) +
+                      ", pruned_duplicate=" + std::to_string(result.pruned_duplicate) +
+                      ", callback_ms=" + std::to_string(result.callback_ms) +
+                      ", engine_ms=" + std::to_string(result.engine_ms) + ")"; });
+
+    py::class_<EvaluationCache>(m, "EvaluationCache")
+        .def(py::init<std::size_t, int>(), py::arg("capacity") = 1 << 16, py::arg("ways") = 4)
+        .def_readonly("hits", &EvaluationCache::hits)
+        .def_readonly("misses", &EvaluationCache::misses)
+        .def_readonly("evictions", &EvaluationCache::evictions)
+        .def_property_readonly("capacity", &EvaluationCache::capacity)
+        .def("__len__", &EvaluationCache::size)
+        .def("clear", &EvaluationCache::clear)
+        .def("__repr__", [](const EvaluationCache &cache)
+             { return "EvaluationCache(capacity=" + std::to_string(cache.capacity()) +
+                      ", hits=" + std::to_string(cache.hits) +
+                      ", misses=" + std::to_string(cache.misses) +
+                      ", evictions=" + std::to_string(cache.evictions) + ")"; });
+
+    py::class_<SearchSession>(m, "SearchSession")
+        .def(py::init<int, std::size_t, int>(), py::arg("beam_width"), py::arg("cache_capacity") = 1 << 16, py::arg("ways") = 4)
+        .def("search", &SearchSession::search, py::arg("state"), py::arg("result") = nullptr)
+        .def("reset", &SearchSession::reset)
+        .def_property_readonly("cache", &SearchSession::cache, py::return_value_policy::reference_internal)
+        .def_property_readonly("reused_states", &SearchSession::reusedStates);
+
     py::class_<ContextualState, PyContextualState, std::shared_ptr<ContextualState>>(m, "ContextualState")
         .def(py::init<>())
         .def(py::init<const ContextualState &>())
@@ -204,9 +482,34 @@ PYBIND11_MODULE(_thunsearch, m)
         .def("advance", &ContextualState::advance)
         .def("cloneAdvanced", &ContextualState::cloneAdvanced)
         .def("clone", &ContextualState::clone)
-        .def("_legal_actions", &ContextualState::_legal_actions);
-
-    m.def("randomAction", &randomAction, R"mydelimiter(
+        .def("_legal_actions", &ContextualState::_legal_actions)
+        .def("hash", &ContextualState::hash)
+        .def("step_cost", &ContextualState::step_cost)
+        .def("heuristic", &ContextualState::heuristic);
+
+    py::class_<RandomGenerator>(m, "RandomGenerator")
+        .def(py::init([](const Seed seed)
+                      { return RandomGenerator(seed); }),
+             py::arg("seed") = py::none())
+        .def("next", &RandomGenerator::next)
+        .def("randrange", &RandomGenerator::randrange)
+        .def("random", &RandomGenerator::random);
+
+    py::class_<NonContextualState, PyNonContextualState, std::shared_ptr<NonContextualState>>(m, "NonContextualState")
+        .def(py::init<>())
+        .def(py::init<const NonContextualState &>())
+        .def_readwrite("evaluated_score_", &NonContextualState::evaluated_score_)
+        .def("neighbor", &NonContextualState::neighbor)
+        .def("transition", &NonContextualState::transition)
+        .def("evaluate_score", &NonContextualState::evaluate_score)
+        .def("has_delta_score", &NonContextualState::has_delta_score)
+        .def("delta_score", &NonContextualState::delta_score)
+        .def("_neighborhood", &NonContextualState::_neighborhood)
+        .def("move_attribute", &NonContextualState::move_attribute)
+        .def("clone", &NonContextualState::clone);
+
+    m.def("randomAction", seeded(&randomAction), py::arg("state"), py::arg("memory_stats") = nullptr, py::arg("seed") = py::none(),
+          py::arg("action_weights") = std::vector<double>(), R"mydelimiter(
         get futuer actions by random
 
         Parameters
@@ -214,7 +517,137 @@ PYBIND11_MODULE(_thunsearch, m)
 
         action: int
     )mydelimiter");
-    m.def("beamSearchAction", &beamSearchAction);
+    m.def("beamSearchAction", &beamSearchAction, py::arg("state"), py::arg("beam_width"), py::arg("memory_stats") = nullptr,
+          py::arg("cache") = nullptr, py::arg("result") = nullptr);
+    m.def("beamStackSearchAction", &beamStackSearchAction, py::arg("state"), py::arg("beam_width"), py::arg("time_limit") = 0,
+          py::arg("on_improve") = nullptr, py::arg("cache") = nullptr, py::arg("result") = nullptr, py::arg("max_depth") = 0,
+          py::arg("score_bound") = false);
+    m.def("bestFirstAction", &bestFirstAction, py::arg("state"), py::arg("weight") = 1.0, py::arg("node_limit") = 100000,
+          py::arg("time_limit") = 0);
+    m.def(
+        "randomRollouts", [](std::shared_ptr<ContextualState> state, const int n, const int threads, const Seed seed, const bool keep_best,
+                             const std::vector<double> &action_weights)
+        {
+            RolloutBatch batch;
+            {
+                py::gil_scoped_release release;
+                batch = randomRollouts(state, n, threads, seed, keep_best, action_weights);
+            }
+            py::array_t<double> scores(py::array::ShapeContainer{static_cast<py::ssize_t>(batch.scores.size())}, batch.scores.data());
+            py::array_t<int> lengths(py::array::ShapeContainer{static_cast<py::ssize_t>(batch.lengths.size())}, batch.lengths.data());
+            py::object best_actions = keep_best ? py::cast(batch.best_actions) : py::none();
+            return py::make_tuple(scores, lengths, best_actions); },
+        py::arg("state"), py::arg("n"), py::arg("threads") = 1, py::arg("seed") = py::none(), py::arg("keep_best") = false,
+        py::arg("action_weights") = std::vector<double>());
+    m.def("nestedMonteCarloAction", seeded(&nestedMonteCarloAction), py::arg("state"), py::arg("level"), py::arg("time_limit") = 0,
+          py::arg("seed") = py::none(), py::arg("action_weights") = std::vector<double>());
+    m.def("nrpaAction", seeded(&nrpaAction), py::arg("state"), py::arg("level"), py::arg("iterations") = 100, py::arg("alpha") = 1.0,
+          py::arg("time_limit") = 0, py::arg("seed") = py::none());
+    m.def("hillClimb", seeded(&hillClimb), py::arg("state"), py::arg("iterations"), py::arg("time_limit") = 0, py::arg("seed") = py::none());
+
+    m.def("parallelTempering", seeded(&parallelTempering), py::arg("state"), py::arg("start_temp"), py::arg("end_temp"), py::arg("time_limit"),
+          py::arg("iterations") = 0, py::arg("threads") = 1, py::arg("swap_interval") = 1000, py::arg("seed") = py::none(),
+          py::call_guard<py::gil_scoped_release>());
+    m.def("tabuSearch", &tabuSearch, py::arg("state"), py::arg("iterations"), py::arg("time_limit") = 0, py::arg("tenure") = 7);
+
+    py::enum_<TemperatureSchedule>(m, "TemperatureSchedule")
+        .value("Linear", TemperatureSchedule::Linear)
+        .value("Exponential", TemperatureSchedule::Exponential);
+    m.def(
+        "simulatedAnnealing",
+        [](std::shared_ptr<NonContextualState> state, const double start_temp, const double end_temp, const int64_t time_limit,
+           const TemperatureSchedule schedule, const int64_t iterations, const int check_interval, const Seed seed)
+        { return simulatedAnnealing(state, makeTemperatureSchedule(schedule, start_temp, end_temp), time_limit, iterations, check_interval, seed); },
+        py::arg("state"), py::arg("start_temp"), py::arg("end_temp"), py::arg("time_limit"),
+        py::arg("schedule") = TemperatureSchedule::Exponential, py::arg("iterations") = 0, py::arg("check_interval") = 100,
+        py::arg("seed") = py::none());
+    m.def(
+        "simulatedAnnealing",
+        [](std::shared_ptr<NonContextualState> state, const std::function<double(double)> &schedule, const int64_t time_limit,
+           const int64_t iterations, const int check_interval, const Seed seed)
+        { return simulatedAnnealing(state, schedule, time_limit, iterations, check_interval, seed); },
+        py::arg("state"), py::arg("schedule"), py::arg("time_limit"),
+        py::arg("iterations") = 0, py::arg("check_interval") = 100, py::arg("seed") = py::none());
+
+    py::class_<GeneticState, PyGeneticState, std::shared_ptr<GeneticState>>(m, "GeneticState")
+        .def(py::init<>())
+        .def(py::init<const GeneticState &>())
+        .def_readwrite("evaluated_score_", &GeneticState::evaluated_score_)
+        .def("crossover", &GeneticState::crossover)
+        .def("mutate", &GeneticState::mutate)
+        .def("evaluate_score", &GeneticState::evaluate_score)
+        .def("clone", &GeneticState::clone);
+    m.def(
+        "geneticAlgorithm",
+        [](const std::vector<std::shared_ptr<GeneticState>> &population, const int64_t generations, const int64_t time_limit,
+           const int islands, const int migration_interval, const int migration_size, const int elite_size,
+           const int tournament_size, const double mutation_rate, const int threads, const Seed seed)
+        {
+            GeneticConfig config;
+            config.generations = generations;
+            config.time_limit = time_limit;
+            config.islands = islands;
+            config.migration_interval = migration_interval;
+            config.migration_size = migration_size;
+            config.elite_size = elite_size;
+            config.tournament_size = tournament_size;
+            config.mutation_rate = mutation_rate;
+            config.threads = threads;
+            config.seed = seed;
+            return geneticAlgorithm(population, config);
+        },
+        py::arg("population"), py::arg("generations"), py::arg("time_limit") = 0,
+        py::arg("islands") = 1, py::arg("migration_interval") = 10, py::arg("migration_size") = 1,
+        py::arg("elite_size") = 1, py::arg("tournament_size") = 3, py::arg("mutation_rate") = 0.2,
+        py::arg("threads") = 1, py::arg("seed") = py::none(), py::call_guard<py::gil_scoped_release>());
+
+    py::class_<AlternateState, PyAlternateState, std::shared_ptr<AlternateState>>(m, "AlternateState")
+        .def(py::init<>())
+        .def(py::init<const AlternateState &>())
+        .def("is_done", &AlternateState::is_done)
+        .def("evaluate_score", &AlternateState::evaluate_score)
+        .def("advance", &AlternateState::advance)
+        .def("hash", &AlternateState::hash)
+        .def("clone", &AlternateState::clone)
+        .def("_legal_actions", &AlternateState::_legal_actions);
+    m.def("alphaBetaAction", &alphaBetaAction, py::arg("state"), py::arg("depth"), py::arg("time_limit") = 0, py::arg("table_size") = 1 << 16);
+
+    py::class_<AlternateTreeSearch>(m, "AlternateTreeSearch")
+        .def("search", &AlternateTreeSearch::search, py::arg("state"), py::arg("playout_number"), py::arg("time_limit") = 0)
+        .def("advance", &AlternateTreeSearch::advance, py::arg("action"))
+        .def("reset", &AlternateTreeSearch::reset)
+        .def_property_readonly("root_visits", &AlternateTreeSearch::rootVisits)
+        .def_property_readonly("node_count", &AlternateTreeSearch::nodeCount);
+    py::class_<MctsSession, AlternateTreeSearch>(m, "MctsSession")
+        .def(py::init([](const double c, const int expand_threshold, const int node_limit, const Seed seed)
+                      { return new MctsSession(c, expand_threshold, node_limit, RandomGenerator(seed)); }),
+             py::arg("c") = 1.0, py::arg("expand_threshold") = 10, py::arg("node_limit") = 100000, py::arg("seed") = py::none());
+    py::class_<ThunderSession, AlternateTreeSearch>(m, "ThunderSession")
+        .def(py::init([](const double score_scale, const int expand_threshold, const int node_limit, const Seed seed)
+                      { return new ThunderSession(score_scale, expand_threshold, node_limit, RandomGenerator(seed)); }),
+             py::arg("score_scale") = 1.0, py::arg("expand_threshold") = 1, py::arg("node_limit") = 100000, py::arg("seed") = py::none());
+    m.def("mctsAction", seeded(&mctsAction), py::arg("state"), py::arg("playout_number"), py::arg("time_limit") = 0,
+          py::arg("c") = 1.0, py::arg("expand_threshold") = 10, py::arg("node_limit") = 100000, py::arg("seed") = py::none());
+    m.def("thunderSearchAction", seeded(&thunderSearchAction), py::arg("state"), py::arg("playout_number"), py::arg("time_limit") = 0,
+          py::arg("score_scale") = 1.0, py::arg("expand_threshold") = 1, py::arg("node_limit") = 100000, py::arg("seed") = py::none());
+    py::enum_<ParallelMode>(m, "ParallelMode")
+        .value("Tree", ParallelMode::Tree)
+        .value("Root", ParallelMode::Root);
+    m.def("parallelMctsAction", seeded(&parallelMctsAction), py::arg("state"), py::arg("playout_number"), py::arg("time_limit") = 0,
+          py::arg("threads") = 1, py::arg("mode") = ParallelMode::Tree, py::arg("c") = 1.0, py::arg("virtual_loss") = 1,
+          py::arg("expand_threshold") = 10, py::arg("node_limit") = 100000, py::arg("seed") = py::none(),
+          py::call_guard<py::gil_scoped_release>());
+
+    py::class_<SimultaneousState, PySimultaneousState, std::shared_ptr<SimultaneousState>>(m, "SimultaneousState")
+        .def(py::init<>())
+        .def(py::init<const SimultaneousState &>())
+        .def("is_done", &SimultaneousState::is_done)
+        .def("evaluate_score", &SimultaneousState::evaluate_score)
+        .def("advance", &SimultaneousState::advance)
+        .def("clone", &SimultaneousState::clone)
+        .def("_legal_actions", &SimultaneousState::_legal_actions);
+    m.def("ductAction", seeded(&ductAction), py::arg("state"), py::arg("player_id"), py::arg("playout_number"), py::arg("time_limit") = 0,
+          py::arg("c") = 1.0, py::arg("expand_threshold") = 10, py::arg("node_limit") = 100000, py::arg("seed") = py::none());
 
 #ifdef VERSION_INFO
     m.attr("__version__") = MACRO_STRINGIFY(VERSION_INFO);
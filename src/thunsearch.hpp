@@ -0,0 +1,4107 @@
+#pragma once
+
+// 探索エンジン本体。Pythonに依存しないので、拡張モジュールとネイティブベンチマークの両方から読み込む
+
+#include <random>
+#include <memory>
+#include <algorithm>
+#include <queue>
+#include <iterator>
+#include <atomic>
+#include <string>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <cmath>
+#include <limits>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <cassert>
+
+// 要素数が少ない間はヒープ確保をせずに内部の固定長領域を使う可変長配列
+// 合法手のように要素数の上限がおおよそ決まっている用途で使う
+template <class T, std::size_t N>
+class SmallVector
+{
+public:
+    SmallVector() : data_(inline_), size_(0), capacity_(N) {}
+    SmallVector(const SmallVector &) = delete;
+    SmallVector &operator=(const SmallVector &) = delete;
+    ~SmallVector()
+    {
+        if (data_ != inline_)
+            delete[] data_;
+    }
+
+    void clear() { size_ = 0; }
+    std::size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    T *begin() { return data_; }
+    T *end() { return data_ + size_; }
+    const T *begin() const { return data_; }
+    const T *end() const { return data_ + size_; }
+    T &operator[](std::size_t i) { return data_[i]; }
+    const T &operator[](std::size_t i) const { return data_[i]; }
+
+    void reserve(std::size_t capacity)
+    {
+        if (capacity > capacity_)
+            grow(capacity);
+    }
+
+    void push_back(const T &value)
+    {
+        if (size_ == capacity_)
+            grow(capacity_ * 2);
+        data_[size_++] = value;
+    }
+
+    template <class Iterator>
+    void assign(Iterator first, Iterator last)
+    {
+        clear();
+        reserve(static_cast<std::size_t>(std::distance(first, last)));
+        for (; first != last; ++first)
+            data_[size_++] = *first;
+    }
+
+private:
+    void grow(std::size_t capacity)
+    {
+        T *data = new T[capacity];
+        std::copy(data_, data_ + size_, data);
+        if (data_ != inline_)
+            delete[] data_;
+        data_ = data;
+        capacity_ = capacity;
+    }
+
+    T inline_[N];
+    T *data_;
+    std::size_t size_;
+    std::size_t capacity_;
+};
+
+// 合法手の受け取り用バッファ。32手までは確保なしで書き込める
+using ActionBuffer = SmallVector<int, 32>;
+
+// 探索1回分のメモリ使用状況。探索関数に渡したときだけ計測される
+struct SearchMemoryStats
+{
+    long long live_states = 0;          // 探索終了時点で生存している探索中に複製した状態数
+    long long peak_live_states = 0;     // 探索中に複製した状態の同時生存数の最大値
+    long long total_clones = 0;         // 探索中に複製した状態の総数
+    long long bytes_allocated = 0;      // 探索器自身のコンテナが確保したバイト数の累計
+    long long peak_ancestor_states = 0; // 経路復元のためだけに生存している祖先状態数の最大値
+};
+
+// 探索1回分の結果と統計。探索関数に渡したときだけ記録される
+struct SearchResult
+{
+    std::vector<int> actions;         // 返した行動列
+    double score = 0;                 // 行動列の最後の状態の評価値
+    long long nodes_expanded = 0;     // 合法手を列挙して子をつくった状態数
+    long long clones = 0;             // つくった子の数
+    long long pruned_dead = 0;        // 合法でないので捨てた子の数
+    long long pruned_beam = 0;        // ビーム幅からあふれて捨てた子の数
+    long long pruned_duplicate = 0;   // 同じ層に同じ状態があったので捨てた子の数
+    int depth = 0;                    // 子をつくった最も深い層
+    double callback_ms = 0;           // 状態のメソッドの中で過ごした時間。Pythonの状態ならPython側の時間
+    double engine_ms = 0;             // 探索全体の時間からcallback_msを除いた時間
+};
+
+// 探索の各段階の開始時刻と所要時間を記録し、Chromeのトレース形式(chrome://tracing, Perfetto)で書き出す
+// スレッドごとのリングバッファに、そのスレッドだけが書き込むので記録中はロックを取らない
+// バッファが一杯になったら古いイベントから上書きする。同時に動かせるトレーサは1つだけ
+class Tracer
+{
+private:
+    struct Event
+    {
+        const char *name; // 文字列リテラルだけを渡す
+        int64_t start_ns;
+        int64_t duration_ns;
+        int depth; // 負なら出力しない
+    };
+
+    struct ThreadBuffer
+    {
+        std::vector<Event> events;
+        uint64_t written = 0; // これまでに書いた数。容量を超えた分は上書きされている
+    };
+
+    static std::atomic<Tracer *> &activeTracer()
+    {
+        static std::atomic<Tracer *> active{nullptr};
+        return active;
+    }
+
+    // startごとに増やす番号。スレッドが覚えているバッファが今の記録のものかを見分ける
+    static uint64_t nextGeneration()
+    {
+        static std::atomic<uint64_t> generation{0};
+        return ++generation;
+    }
+
+    std::size_t capacity_;
+    uint64_t generation_ = 0;
+    std::chrono::steady_clock::time_point origin_;
+    std::mutex mutex_; // バッファの登録と書き出しだけで取る
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers_;
+
+    ThreadBuffer &threadBuffer()
+    {
+        struct Cache
+        {
+            uint64_t generation = 0;
+            ThreadBuffer *buffer = nullptr;
+        };
+        thread_local Cache cache;
+        if (cache.generation != generation_)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            buffers_.emplace_back(new ThreadBuffer());
+            buffers_.back()->events.resize(capacity_);
+            cache.generation = generation_;
+            cache.buffer = buffers_.back().get();
+        }
+        return *cache.buffer;
+    }
+
+public:
+    // capacityはスレッドごとに残すイベント数
+    explicit Tracer(const std::size_t capacity) : capacity_(capacity)
+    {
+        if (capacity < 1)
+            throw std::invalid_argument("capacity must be positive");
+    }
+    ~Tracer() { stop(); }
+
+    // 動作中のトレーサ。なければnullptr
+    static Tracer *active() { return activeTracer().load(std::memory_order_acquire); }
+
+    // 前回の記録を捨てて記録を始める
+    void start()
+    {
+        Tracer *running = active();
+        if (running == this)
+            return;
+        if (running != nullptr)
+            throw std::logic_error("another tracer is already running");
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            buffers_.clear();
+        }
+        generation_ = nextGeneration();
+        origin_ = std::chrono::steady_clock::now();
+        activeTracer().store(this, std::memory_order_release);
+    }
+
+    void stop()
+    {
+        Tracer *expected = this;
+        activeTracer().compare_exchange_strong(expected, nullptr);
+    }
+
+    // startからの経過時間(ナノ秒)
+    int64_t now() const
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin_).count();
+    }
+
+    void record(const char *name, const int depth, const int64_t start_ns, const int64_t end_ns)
+    {
+        auto &buffer = threadBuffer();
+        buffer.events[buffer.written % capacity_] = Event{name, start_ns, end_ns - start_ns, depth};
+        buffer.written++;
+    }
+
+    // 残っているイベント数
+    std::size_t eventCount()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::size_t count = 0;
+        for (const auto &buffer : buffers_)
+            count += static_cast<std::size_t>(std::min<uint64_t>(buffer->written, capacity_));
+        return count;
+    }
+
+    // 上書きされて失われたイベント数
+    std::size_t droppedEvents()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::size_t count = 0;
+        for (const auto &buffer : buffers_)
+            count += static_cast<std::size_t>(buffer->written - std::min<uint64_t>(buffer->written, capacity_));
+        return count;
+    }
+
+    // 記録を止めてpathにJSONで書き出す。スレッドはバッファを登録した順に番号をつける
+    void dump(const std::string &path)
+    {
+        stop();
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::ofstream out(path);
+        if (!out)
+            throw std::runtime_error("cannot open " + path);
+        // tsとdurはマイクロ秒なので、ナノ秒まで残すよう小数点以下3桁の固定小数点で書く
+        out << std::fixed << std::setprecision(3);
+        out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+        bool first = true;
+        for (std::size_t tid = 0; tid < buffers_.size(); tid++)
+        {
+            const auto &buffer = *buffers_[tid];
+            out << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid
+                << ",\"args\":{\"name\":\"search thread " << tid << "\"}}";
+            first = false;
+            const uint64_t kept = std::min<uint64_t>(buffer.written, capacity_);
+            for (uint64_t i = buffer.written - kept; i < buffer.written; i++)
+            {
+                const Event &event = buffer.events[i % capacity_];
+                out << ",\n{\"name\":\"" << event.name << "\",\"cat\":\"search\",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid
+                    << ",\"ts\":" << event.start_ns / 1000.0 << ",\"dur\":" << event.duration_ns / 1000.0;
+                if (event.depth >= 0)
+                    out << ",\"args\":{\"depth\":" << event.depth << "}";
+                out << "}";
+            }
+        }
+        out << "\n]}\n";
+    }
+};
+
+// 生存している間を1つのイベントとして、動作中のトレーサに記録する
+// トレーサが動いていなければ、ポインタを1回読むだけで何もしない
+class TraceScope
+{
+private:
+    Tracer *tracer_;
+    const char *name_;
+    int depth_;
+    int64_t start_ns_ = 0;
+
+public:
+    explicit TraceScope(const char *name, const int depth = -1) : tracer_(Tracer::active()), name_(name), depth_(depth)
+    {
+        if (tracer_ != nullptr)
+            start_ns_ = tracer_->now();
+    }
+    ~TraceScope()
+    {
+        if (tracer_ != nullptr)
+            tracer_->record(name_, depth_, start_ns_, tracer_->now());
+    }
+
+    // このスコープを記録しない
+    void cancel() { tracer_ = nullptr; }
+
+    TraceScope(const TraceScope &) = delete;
+    TraceScope &operator=(const TraceScope &) = delete;
+};
+
+// 状態とコンテナから共有される計測用のカウンタ
+// 並列探索からも更新できるようにatomicで持つ
+class MemoryCounter
+{
+public:
+    std::atomic<long long> live_states{0};
+    std::atomic<long long> peak_live_states{0};
+    std::atomic<long long> total_clones{0};
+    std::atomic<long long> bytes_allocated{0};
+    std::atomic<long long> peak_ancestor_states{0};
+
+    void onCreate()
+    {
+        total_clones.fetch_add(1, std::memory_order_relaxed);
+        updateMax(peak_live_states, live_states.fetch_add(1, std::memory_order_relaxed) + 1);
+    }
+    void onDestroy() { live_states.fetch_sub(1, std::memory_order_relaxed); }
+    void onAllocate(std::size_t bytes) { bytes_allocated.fetch_add(static_cast<long long>(bytes), std::memory_order_relaxed); }
+
+    static void updateMax(std::atomic<long long> &target, const long long value)
+    {
+        long long now = target.load(std::memory_order_relaxed);
+        while (now < value && !target.compare_exchange_weak(now, value, std::memory_order_relaxed))
+        {
+        }
+    }
+};
+
+// 確保したバイト数をMemoryCounterに加算するアロケータ
+// counterがnullptrのときは通常のアロケータと同じ動作をする
+template <class T>
+class CountingAllocator
+{
+public:
+    using value_type = T;
+    MemoryCounter *counter_ = nullptr;
+
+    CountingAllocator() = default;
+    explicit CountingAllocator(MemoryCounter *counter) : counter_(counter) {}
+    template <class U>
+    CountingAllocator(const CountingAllocator<U> &other) : counter_(other.counter_) {}
+
+    T *allocate(std::size_t n)
+    {
+        if (counter_ != nullptr)
+            counter_->onAllocate(n * sizeof(T));
+        return std::allocator<T>().allocate(n);
+    }
+    void deallocate(T *p, std::size_t n) { std::allocator<T>().deallocate(p, n); }
+
+    template <class U>
+    bool operator==(const CountingAllocator<U> &other) const { return counter_ == other.counter_; }
+    template <class U>
+    bool operator!=(const CountingAllocator<U> &other) const { return counter_ != other.counter_; }
+};
+
+class ContextualState;
+
+// 1つの行動で進めた子の状態と、その評価値・終了判定・合法でないかの判定
+struct StepResult
+{
+    std::shared_ptr<ContextualState> state;
+    double score = 0;
+    bool done = false;
+    bool dead = false;
+    uint64_t hash = 0; // 求めたときだけ設定される
+};
+
+class ContextualState : public std::enable_shared_from_this<ContextualState>
+{
+public:
+    std::shared_ptr<ContextualState> parent_ = nullptr;
+    double evaluated_score_ = 0; // 探索上で評価したスコア
+    int last_action_ = -1;       // 直前に選択した行動
+    std::shared_ptr<MemoryCounter> memory_counter_ = nullptr; // 計測中の探索で複製された場合のみ設定される
+
+    ContextualState() = default;
+    // 計測用のカウンタは複製先に引き継がない
+    ContextualState(const ContextualState &other)
+        : std::enable_shared_from_this<ContextualState>(other),
+          parent_(other.parent_),
+          evaluated_score_(other.evaluated_score_),
+          last_action_(other.last_action_) {}
+    virtual ~ContextualState()
+    {
+        if (memory_counter_ != nullptr)
+            memory_counter_->onDestroy();
+    }
+    virtual std::shared_ptr<ContextualState> clone() const = 0;
+    virtual void advance(const int action) = 0;
+    virtual std::vector<int> _legal_actions() = 0;
+
+    // 呼び出し側が使い回すバッファに合法手を書き込む
+    // C++で実装する状態はこちらを上書きすると探索中のヒープ確保がなくなる
+    virtual void legal_actions_into(ActionBuffer &buffer)
+    {
+        auto actions = _legal_actions();
+        buffer.assign(actions.begin(), actions.end());
+    }
+
+    // ゲームの終了判定
+    virtual bool is_done() = 0;
+
+    virtual bool is_dead() = 0;
+
+    // 探索用の盤面評価をする
+    virtual double evaluate_score() = 0;
+
+    // 同じ状態を見分けるためのハッシュ値。重複を検出する探索だけが使う
+    virtual uint64_t hash()
+    {
+        throw std::logic_error("hash is not implemented");
+    }
+
+    // この状態でactionを選ぶときにかかるコスト
+    virtual double step_cost(const int /* action */) { return 1.0; }
+
+    // 終了状態までに残りかかるコストの見積もり
+    virtual double heuristic() { return 0.0; }
+
+    // プレイアウトで合法手を選ぶ重み。legal_actions_intoと同じ順にweightsへ書き込む
+    // falseを返すと重みなしとして扱う
+    virtual bool action_weights_into(std::vector<double> & /* weights */) { return false; }
+
+    // actionで進めた子をつくり、評価値と終了判定もまとめてresultに書き込む
+    // 上書きすると探索は子1つにつき1回だけ呼ぶ。falseを返すとclone・advanceなどを個別に呼ぶ
+    // 合法でない子のscoreとdoneは使われない
+    virtual bool step_into(const int /* action */, StepResult & /* result */) { return false; }
+
+    std::shared_ptr<ContextualState> cloneAdvanced(int action)
+    {
+        auto clone = this->clone();
+        clone->advance(action);
+        clone->parent_ = shared_from_this();
+        clone->last_action_ = action;
+        return clone;
+    }
+};
+
+// 探索時のソート用に評価を比較する
+inline bool operator<(const ContextualState &state_1, const ContextualState &state_2)
+{
+    return state_1.evaluated_score_ < state_2.evaluated_score_;
+}
+inline bool operator<(const std::shared_ptr<ContextualState> &state_1, const std::shared_ptr<ContextualState> &state_2)
+{
+    return state_1->evaluated_score_ < state_2->evaluated_score_;
+}
+
+// 探索中に複製した状態とコンテナの確保量を数える
+// statsがnullptrのときは何も数えない
+class MemoryTracker
+{
+public:
+    explicit MemoryTracker(SearchMemoryStats *stats)
+        : stats_(stats), counter_(stats != nullptr ? std::make_shared<MemoryCounter>() : nullptr) {}
+
+    bool enabled() const { return counter_ != nullptr; }
+
+    template <class T>
+    CountingAllocator<T> allocator() const { return CountingAllocator<T>(counter_.get()); }
+
+    // 探索中に複製した状態を計測対象にする
+    void track(ContextualState &state) const
+    {
+        if (counter_ == nullptr)
+            return;
+        state.memory_counter_ = counter_;
+        counter_->onCreate();
+    }
+
+    // 探索の先端にある状態数から、経路復元のためだけに残っている祖先の数を記録する
+    void recordFrontier(const long long frontier_states) const
+    {
+        if (counter_ == nullptr)
+            return;
+        MemoryCounter::updateMax(counter_->peak_ancestor_states, counter_->live_states.load() - frontier_states);
+    }
+
+    // 計測結果を呼び出し側に書き出す
+    void report() const
+    {
+        if (stats_ == nullptr)
+            return;
+        stats_->live_states = counter_->live_states.load();
+        stats_->peak_live_states = counter_->peak_live_states.load();
+        stats_->total_clones = counter_->total_clones.load();
+        stats_->bytes_allocated = counter_->bytes_allocated.load();
+        stats_->peak_ancestor_states = counter_->peak_ancestor_states.load();
+    }
+
+private:
+    SearchMemoryStats *stats_;
+    std::shared_ptr<MemoryCounter> counter_;
+};
+
+// 64bit整数のビットをかき混ぜる(splitmix64の出力関数)
+inline uint64_t mixHash(uint64_t x)
+{
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+// 状態のハッシュ値から評価値を引く固定容量のキャッシュ
+// ways個ずつの組に分けたセットアソシエイティブ方式で、組の中はクロック方式で置き換える
+// 4-wayなら1つの組のキーと評価値が64byteに収まり、1回の参照で触るキャッシュラインは1本で済む
+// ハッシュ値が等しい状態は同じ状態とみなす。スレッドセーフではないので、並列探索には渡さない
+class EvaluationCache
+{
+private:
+    struct Entry
+    {
+        uint64_t key;
+        double score;
+    };
+
+    // 組ごとの管理情報。validとreferencedは組の中の位置ごとのビット
+    struct SetInfo
+    {
+        uint32_t valid = 0;
+        uint32_t referenced = 0;
+        uint32_t hand = 0;
+    };
+
+    int ways_;
+    uint64_t set_mask_;
+    std::vector<Entry> entries_;
+    std::vector<SetInfo> sets_;
+
+public:
+    long long hits = 0;
+    long long misses = 0;
+    long long evictions = 0;
+
+    // capacity以上になるよう組の数を2の累乗に切り上げる
+    EvaluationCache(const std::size_t capacity, const int ways)
+        : ways_(ways)
+    {
+        if (ways < 1 || ways > 32)
+            throw std::invalid_argument("ways must be between 1 and 32");
+        if (capacity < 1)
+            throw std::invalid_argument("capacity must be positive");
+        std::size_t set_count = 1;
+        while (set_count * static_cast<std::size_t>(ways) < capacity)
+            set_count <<= 1;
+        set_mask_ = set_count - 1;
+        entries_.resize(set_count * ways);
+        sets_.resize(set_count);
+    }
+
+    std::size_t capacity() const { return entries_.size(); }
+
+    std::size_t size() const
+    {
+        std::size_t count = 0;
+        for (const auto &set : sets_)
+        {
+            for (uint32_t valid = set.valid; valid != 0; valid &= valid - 1)
+                count++;
+        }
+        return count;
+    }
+
+    void clear()
+    {
+        std::fill(sets_.begin(), sets_.end(), SetInfo());
+        hits = misses = evictions = 0;
+    }
+
+    // 見つかればscoreに書き込んでtrueを返す
+    bool lookup(const uint64_t key, double &score)
+    {
+        const std::size_t set_index = mixHash(key) & set_mask_;
+        SetInfo &set = sets_[set_index];
+        const Entry *entries = &entries_[set_index * ways_];
+        for (int way = 0; way < ways_; way++)
+        {
+            if ((set.valid >> way & 1) && entries[way].key == key)
+            {
+                set.referenced |= 1u << way;
+                score = entries[way].score;
+                hits++;
+                return true;
+            }
+        }
+        misses++;
+        return false;
+    }
+
+    // 空きがなければ、時計の針を進めて最近参照されていない位置を置き換える
+    void store(const uint64_t key, const double score)
+    {
+        const std::size_t set_index = mixHash(key) & set_mask_;
+        SetInfo &set = sets_[set_index];
+        Entry *entries = &entries_[set_index * ways_];
+        for (int way = 0; way < ways_; way++)
+        {
+            if ((set.valid >> way & 1) && entries[way].key == key)
+            {
+                entries[way].score = score;
+                return;
+            }
+        }
+        const uint32_t full = ways_ == 32 ? 0xffffffffu : (1u << ways_) - 1;
+        int way;
+        if (set.valid != full)
+        {
+            way = 0;
+            while (set.valid >> way & 1)
+                way++;
+        }
+        else
+        {
+            while (set.referenced >> set.hand & 1)
+            {
+                set.referenced &= ~(1u << set.hand);
+                set.hand = (set.hand + 1) % ways_;
+            }
+            way = static_cast<int>(set.hand);
+            set.hand = (set.hand + 1) % ways_;
+            evictions++;
+        }
+        entries[way] = Entry{key, score};
+        set.valid |= 1u << way;
+        set.referenced &= ~(1u << way);
+    }
+};
+
+// 状態を評価する。cacheを渡すと、evaluate_scoreを呼ぶ前にhash()で引く
+// hashを渡すと、求めたhash()を書き込む
+inline double evaluateCached(ContextualState &state, EvaluationCache *cache, uint64_t *hash = nullptr)
+{
+    if (cache == nullptr && hash == nullptr)
+        return state.evaluate_score();
+    const uint64_t key = state.hash();
+    if (hash != nullptr)
+        *hash = key;
+    if (cache == nullptr)
+        return state.evaluate_score();
+    double score;
+    if (cache->lookup(key, score))
+        return score;
+    score = state.evaluate_score();
+    cache->store(key, score);
+    return score;
+}
+
+// stateをactionで進めた子をつくって評価し、親と直前の行動を設定する
+// cacheがなければstep_intoを試し、実装されていなければ個別に呼ぶ。合法でない子は評価しない
+// cacheがあれば評価値をhash()で引くので、個別に呼ぶ
+// with_hashなら合法な子のhash()もresult.hashに書き込む。このときはhash()をどのみち呼ぶので、cacheがあってもstep_intoを先に試す
+inline void stepChild(ContextualState &state, const int action, EvaluationCache *cache, StepResult &result, const bool with_hash = false)
+{
+    bool stepped = false;
+    if (cache == nullptr || with_hash)
+    {
+        TraceScope trace("step");
+        stepped = state.step_into(action, result);
+        if (!stepped)
+            trace.cancel();
+    }
+    if (!stepped)
+    {
+        {
+            TraceScope trace("clone");
+            result.state = state.clone();
+        }
+        {
+            TraceScope trace("advance");
+            result.state->advance(action);
+        }
+        {
+            TraceScope trace("is_dead");
+            result.dead = result.state->is_dead();
+        }
+        if (!result.dead)
+        {
+            {
+                TraceScope trace("evaluate_score");
+                result.score = evaluateCached(*result.state, cache, with_hash ? &result.hash : nullptr);
+            }
+            TraceScope trace("is_done");
+            result.done = result.state->is_done();
+        }
+        else
+        {
+            result.score = 0;
+            result.done = false;
+        }
+    }
+    else if (with_hash && !result.dead)
+    {
+        TraceScope trace("hash");
+        result.hash = result.state->hash();
+    }
+    result.state->parent_ = state.shared_from_this();
+    result.state->last_action_ = action;
+    result.state->evaluated_score_ = result.score;
+}
+
+// プレイアウトを終える状態か
+inline bool isRolloutEnd(ContextualState &state) { return state.is_done() || state.is_dead(); }
+
+// 終わりの状態までランダムに行動を選んで進め、最後の状態を返す
+// randomActionとモンテカルロ法のプレイアウトで共通に使う
+// 始めに1度だけ複製し、以降はその状態をその場で進める。途中の状態や親へのリンクは残らないので、
+// 行動列が必要ならon_stepで記録する
+// pick(state, legal_actions)は選ぶ合法手の添字を返し、on_step(state, action)は1手進めるごとに呼ばれる
+template <class State, class Pick, class OnStep>
+std::shared_ptr<State> randomRollout(const std::shared_ptr<State> &state, Pick &&pick, OnStep &&on_step)
+{
+    if (isRolloutEnd(*state))
+        return state;
+    auto rollout_state = state->clone();
+    ActionBuffer legal_actions;
+    while (!isRolloutEnd(*rollout_state))
+    {
+        rollout_state->legal_actions_into(legal_actions);
+        if (legal_actions.empty())
+            break;
+
+        const int action = legal_actions[pick(*rollout_state, legal_actions)];
+        rollout_state->advance(action);
+        on_step(*rollout_state, action);
+    }
+    return rollout_state;
+}
+
+// 探索を始めた状態からstateまでの行動列を、親をたどって復元する
+inline std::vector<int> actionsTo(std::shared_ptr<ContextualState> state)
+{
+    std::vector<int> actions{};
+    while (state->parent_ != nullptr)
+    {
+        actions.emplace_back(state->last_action_);
+        state = state->parent_;
+    }
+    std::reverse(actions.begin(), actions.end());
+    return actions;
+}
+
+// 探索の統計を数え、終了時にSearchResultへ書き出す
+// 数えるだけなら安いので常に数え、時間はresultを渡されたときだけ計る
+class SearchProfiler
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // 生存している間を状態のメソッドの実行時間として数える
+    class CallbackScope
+    {
+    private:
+        SearchProfiler &profiler_;
+        Clock::time_point start_;
+
+    public:
+        explicit CallbackScope(SearchProfiler &profiler) : profiler_(profiler)
+        {
+            if (profiler_.enabled())
+                start_ = Clock::now();
+        }
+        ~CallbackScope()
+        {
+            if (profiler_.enabled())
+                profiler_.callback_time_ += Clock::now() - start_;
+        }
+    };
+
+    SearchResult stats; // 記録中の統計。actionsとscoreと時間はfinishで埋める
+
+    explicit SearchProfiler(SearchResult *result) : result_(result), start_(Clock::now()) {}
+
+    bool enabled() const { return result_ != nullptr; }
+
+    void finish(const std::vector<int> &actions, const double score)
+    {
+        if (result_ == nullptr)
+            return;
+        const double total_ms = std::chrono::duration<double, std::milli>(Clock::now() - start_).count();
+        stats.actions = actions;
+        stats.score = score;
+        stats.callback_ms = std::chrono::duration<double, std::milli>(callback_time_).count();
+        stats.engine_ms = std::max(0.0, total_ms - stats.callback_ms);
+        *result_ = stats;
+    }
+
+private:
+    SearchResult *result_;
+    Clock::time_point start_;
+    Clock::duration callback_time_{0};
+};
+
+// stateを展開し、合法手ごとにstepChildで子をつくって、合法な子ごとにvisit(step)を呼ぶ
+// ビームサーチ系の探索で共通の展開処理。depthはstateの深さで、子の深さを統計に記録する
+// legal_actionsとstepは呼び出し側が使い回すバッファ。memoryを渡すと、合法でない子も含めて複製を数える
+template <class Visit>
+inline void expandChildren(ContextualState &state, const int depth, EvaluationCache *cache, const bool with_hash,
+                           ActionBuffer &legal_actions, StepResult &step, SearchProfiler &profiler, const MemoryTracker *memory, Visit &&visit)
+{
+    TraceScope trace("expand", depth);
+    {
+        SearchProfiler::CallbackScope scope(profiler);
+        TraceScope trace_legal("legal_actions");
+        state.legal_actions_into(legal_actions);
+    }
+    profiler.stats.nodes_expanded++;
+    for (const int action : legal_actions)
+    {
+        {
+            SearchProfiler::CallbackScope scope(profiler);
+            stepChild(state, action, cache, step, with_hash);
+        }
+        profiler.stats.clones++;
+        if (memory != nullptr)
+            memory->track(*step.state);
+        if (step.dead)
+        {
+            profiler.stats.pruned_dead++;
+            step.state = nullptr;
+            continue;
+        }
+        profiler.stats.depth = std::max(profiler.stats.depth, depth + 1);
+        visit(step);
+    }
+}
+
+// ビーム幅を指定してビームサーチで行動を決定する
+// cacheを渡すと、同じ状態の評価を使い回す
+inline std::vector<int> beamSearchAction(std::shared_ptr<ContextualState> state, const int beam_width, SearchMemoryStats *memory_stats = nullptr,
+                                         EvaluationCache *cache = nullptr, SearchResult *result = nullptr)
+{
+    if (beam_width < 1)
+        throw std::invalid_argument("beam_width must be positive");
+    SearchProfiler profiler(result);
+    using ContextualStatePtr = std::shared_ptr<ContextualState>;
+    using Beam = std::priority_queue<ContextualStatePtr, std::vector<ContextualStatePtr, CountingAllocator<ContextualStatePtr>>, std::greater<ContextualStatePtr>>;
+    MemoryTracker memory(memory_stats);
+    const auto beam_allocator = memory.allocator<ContextualStatePtr>();
+    Beam now_beam{std::greater<ContextualStatePtr>(), Beam::container_type(beam_allocator)};
+    std::shared_ptr<ContextualState> best_state = nullptr;
+
+    ActionBuffer legal_actions;
+    StepResult step;
+
+    now_beam.emplace(state);
+    for (int t = 0;; t++)
+    {
+        Beam next_beam{std::greater<ContextualStatePtr>(), Beam::container_type(beam_allocator)};
+        std::shared_ptr<ContextualState> layer_best = nullptr; // この層で展開した中で評価が最も高い状態
+
+        for (int i = 0; i < beam_width; i++)
+        {
+            if (now_beam.empty())
+                break;
+            std::shared_ptr<ContextualState> now_state = now_beam.top();
+            // cout << "t " << t << "\tnow_score:" << now_state->evaluated_score_ << endl;
+
+            now_beam.pop();
+            if (layer_best == nullptr || layer_best < now_state)
+                layer_best = now_state;
+            expandChildren(*now_state, t, cache, false, legal_actions, step, profiler, &memory, [&](StepResult &child)
+                           {
+                               auto next_state = std::move(child.state);
+                               if (next_beam.size() >= beam_width && next_beam.top()->evaluated_score_ >= next_state->evaluated_score_)
+                               {
+                                   profiler.stats.pruned_beam++;
+                                   return;
+                               }
+
+                               assert(next_state->parent_ != nullptr);
+
+                               if (child.done)
+                               {
+                                   if (best_state == nullptr || next_state > best_state)
+                                   {
+                                       best_state = next_state;
+                                   }
+                                   return;
+                               }
+
+                               // cout << "next_state " << next_state->evaluated_score_ << endl;
+                               next_beam.emplace(next_state);
+                               if (next_beam.size() > beam_width)
+                               {
+                                   next_beam.pop();
+                                   profiler.stats.pruned_beam++;
+                               } });
+        }
+
+        // 終了状態に届かないままビームが空になったら、最後の層で最も良い状態までの行動列を返す
+        if (best_state == nullptr && next_beam.empty())
+        {
+            best_state = layer_best;
+        }
+        if (best_state != nullptr)
+        {
+            break;
+        }
+        now_beam = next_beam;
+        memory.recordFrontier(static_cast<long long>(now_beam.size()));
+    }
+    memory.report();
+
+    auto actions = actionsTo(best_state);
+    profiler.finish(actions, best_state->evaluated_score_);
+    return actions;
+}
+
+// 制限時間を管理する。time_thresholdが0以下なら時間切れにならない
+class TimeKeeper
+{
+private:
+    std::chrono::high_resolution_clock::time_point start_time_;
+    int64_t time_threshold_;
+
+public:
+    // 時間制限をミリ秒単位で指定してインスタンスをつくる。
+    explicit TimeKeeper(const int64_t time_threshold)
+        : start_time_(std::chrono::high_resolution_clock::now()),
+          time_threshold_(time_threshold) {}
+
+    // インスタンス生成した時から指定した時間制限を超過したか判定する。
+    bool isTimeOver() const
+    {
+        if (time_threshold_ <= 0)
+            return false;
+        auto diff = std::chrono::high_resolution_clock::now() - this->start_time_;
+        return std::chrono::duration_cast<std::chrono::milliseconds>(diff).count() >= time_threshold_;
+    }
+
+    // 制限時間のうち経過した割合を[0, 1]で返す。制限時間がなければ0を返す
+    double elapsedRate() const
+    {
+        if (time_threshold_ <= 0)
+            return 0;
+        auto diff = std::chrono::high_resolution_clock::now() - this->start_time_;
+        const double elapsed = std::chrono::duration<double, std::milli>(diff).count();
+        return std::min(1.0, elapsed / static_cast<double>(time_threshold_));
+    }
+};
+
+// xoshiro256**による乱数生成器
+// std::mt19937より状態が小さく(32byte)高速なので、探索の内側のループで使う
+class Xoshiro256
+{
+private:
+    uint64_t s_[4];
+
+    static uint64_t rotl(const uint64_t x, const int k) { return (x << k) | (x >> (64 - k)); }
+
+public:
+    using result_type = uint64_t;
+
+    // splitmix64でシードを4つの内部状態に広げる
+    explicit Xoshiro256(uint64_t seed = 0)
+    {
+        for (auto &s : s_)
+        {
+            seed += 0x9e3779b97f4a7c15ULL;
+            s = mixHash(seed);
+        }
+    }
+
+    static constexpr uint64_t min() { return 0; }
+    static constexpr uint64_t max() { return ~0ULL; }
+
+    uint64_t operator()()
+    {
+        const uint64_t result = rotl(s_[1] * 5, 7) * 9;
+        const uint64_t t = s_[1] << 17;
+        s_[2] ^= s_[0];
+        s_[3] ^= s_[1];
+        s_[1] ^= s_[2];
+        s_[0] ^= s_[3];
+        s_[2] ^= t;
+        s_[3] = rotl(s_[3], 45);
+        return result;
+    }
+
+    // 2^128回分だけ状態を進める。重ならない乱数列を並列に使うときに、列の先頭を作るのに使う
+    void jump()
+    {
+        static const uint64_t JUMP[] = {0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL};
+        uint64_t s[4] = {0, 0, 0, 0};
+        for (const uint64_t jump : JUMP)
+        {
+            for (int b = 0; b < 64; b++)
+            {
+                if (jump & (1ULL << b))
+                {
+                    for (int k = 0; k < 4; k++)
+                        s[k] ^= s_[k];
+                }
+                (*this)();
+            }
+        }
+        for (int k = 0; k < 4; k++)
+            s_[k] = s[k];
+    }
+};
+
+// 近傍選択などに使う乱数生成器。Pythonの状態クラスにも渡される
+class RandomGenerator
+{
+private:
+    Xoshiro256 engine_;
+
+public:
+    explicit RandomGenerator(const uint64_t seed = 0) : engine_(seed) {}
+
+    // seedとstreamの組ごとに別の乱数列をつくる
+    // 仕事の添字をstreamにすれば、どのスレッドが処理しても同じ乱数列になる
+    RandomGenerator(const uint64_t seed, const uint64_t stream) : engine_(seed ^ mixHash(stream + 0x9e3779b97f4a7c15ULL)) {}
+
+    // 今の位置から始まる乱数列を返し、自身は2^128回分先へ進める
+    // 続けて呼べば、スレッドごとに重ならない乱数列を配れる
+    RandomGenerator split()
+    {
+        RandomGenerator stream = *this;
+        engine_.jump();
+        return stream;
+    }
+
+    // 32bitの乱数を返す
+    uint32_t next() { return static_cast<uint32_t>(engine_() >> 32); }
+
+    // [0, n)の整数乱数を返す。剰余の代わりに乗算で範囲を縮める
+    // 空の範囲からは選べないので、nが正でなければ例外を投げる
+    int randrange(const int n)
+    {
+        if (n <= 0)
+            throw std::invalid_argument("randrange requires a positive n");
+        return static_cast<int>((static_cast<uint64_t>(next()) * static_cast<uint32_t>(n)) >> 32);
+    }
+
+    // [0, 1)の実数乱数を返す
+    double random() { return (engine_() >> 11) * (1.0 / 9007199254740992.0); }
+};
+
+// 重みに比例した確率で添字を選ぶWalkerのエイリアス法
+// 構築にO(n)かかるが1回の抽出はO(1)なので、同じ重みから何度も引くときに使う
+class AliasTable
+{
+private:
+    std::vector<double> probability_;
+    std::vector<int> alias_;
+
+public:
+    AliasTable() = default;
+
+    // 重みの合計が0なら空の表になる
+    explicit AliasTable(const std::vector<double> &weights)
+    {
+        const int n = static_cast<int>(weights.size());
+        double total = 0;
+        for (const double weight : weights)
+        {
+            if (!(weight >= 0))
+                throw std::invalid_argument("weights must not be negative");
+            total += weight;
+        }
+        if (n == 0 || total <= 0)
+            return;
+        probability_.resize(n);
+        alias_.resize(n);
+        std::vector<int> small, large;
+        for (int i = 0; i < n; i++)
+        {
+            probability_[i] = weights[i] * n / total;
+            alias_[i] = i;
+            (probability_[i] < 1 ? small : large).emplace_back(i);
+        }
+        while (!small.empty() && !large.empty())
+        {
+            const int s = small.back();
+            small.pop_back();
+            const int l = large.back();
+            alias_[s] = l;
+            probability_[l] -= 1 - probability_[s];
+            if (probability_[l] < 1)
+            {
+                large.pop_back();
+                small.emplace_back(l);
+            }
+        }
+        // 誤差で残った分は確率1にする
+        for (const int i : small)
+            probability_[i] = 1;
+        for (const int i : large)
+            probability_[i] = 1;
+    }
+
+    bool empty() const { return probability_.empty(); }
+
+    int sample(RandomGenerator &rng) const
+    {
+        const int i = rng.randrange(static_cast<int>(probability_.size()));
+        return rng.random() < probability_[i] ? i : alias_[i];
+    }
+};
+
+// weight(i)に比例した確率で[0, n)の添字を選ぶ。表を作らず累積和で1回だけ引く
+// 重みの合計が0なら一様に選ぶ
+template <class Weight>
+int sampleCumulative(const std::size_t n, Weight &&weight, RandomGenerator &rng)
+{
+    double total = 0;
+    for (std::size_t i = 0; i < n; i++)
+    {
+        const double w = weight(i);
+        if (!(w >= 0))
+            throw std::invalid_argument("weights must not be negative");
+        total += w;
+    }
+    if (total <= 0)
+        return rng.randrange(static_cast<int>(n));
+    double threshold = rng.random() * total;
+    for (std::size_t i = 0; i < n; i++)
+    {
+        threshold -= weight(i);
+        if (threshold < 0)
+            return static_cast<int>(i);
+    }
+    // 丸め誤差で最後まで来たときは、重みが正の最後の添字にする
+    for (std::size_t i = n; i-- > 0;)
+    {
+        if (weight(i) > 0)
+            return static_cast<int>(i);
+    }
+    return static_cast<int>(n - 1);
+}
+
+// プレイアウトで合法手を選ぶ方策
+// 状態のaction_weights_intoが重みを返せば、その重みに比例して累積和で選ぶ
+// 返さなければ、行動ごとの重み表をエイリアス法で引いて合法でない行動を棄却し、表もなければ一様に選ぶ
+// 表は探索の間ずっと使い回すので、全ての行動について1度だけ作る
+class RolloutPolicy
+{
+private:
+    // 棄却がこの回数続いたら、合法手だけで累積和から引く
+    static constexpr int MAX_REJECTIONS = 4;
+
+    std::vector<double> action_weights_;
+    AliasTable table_;
+
+    double actionWeight(const int action) const
+    {
+        if (action < 0 || action >= static_cast<int>(action_weights_.size()))
+            return 0;
+        return action_weights_[action];
+    }
+
+    int pickByTable(const ActionBuffer &legal_actions, RandomGenerator &rng) const
+    {
+        for (int t = 0; t < MAX_REJECTIONS; t++)
+        {
+            const int action = table_.sample(rng);
+            for (std::size_t i = 0; i < legal_actions.size(); i++)
+            {
+                if (legal_actions[i] == action)
+                    return static_cast<int>(i);
+            }
+        }
+        return sampleCumulative(
+            legal_actions.size(), [&](const std::size_t i)
+            { return actionWeight(legal_actions[i]); },
+            rng);
+    }
+
+public:
+    // 1回のプレイアウトの間、randomRolloutのpickとして使う
+    // 状態が1度でも重みを返さなければ、そのプレイアウトの残りでは状態に重みを問い合わせない
+    class Picker
+    {
+    private:
+        const RolloutPolicy &policy_;
+        RandomGenerator &rng_;
+        bool ask_state_ = true;
+
+    public:
+        Picker(const RolloutPolicy &policy, RandomGenerator &rng) : policy_(policy), rng_(rng) {}
+
+        int operator()(ContextualState &state, const ActionBuffer &legal_actions)
+        {
+            // スレッドごとに使い回す重みのバッファ
+            thread_local std::vector<double> weights;
+            if (ask_state_ && state.action_weights_into(weights))
+            {
+                if (weights.size() != legal_actions.size())
+                    throw std::invalid_argument("action_weights must return one weight per legal action");
+                return sampleCumulative(
+                    weights.size(), [&](const std::size_t i)
+                    { return weights[i]; },
+                    rng_);
+            }
+            ask_state_ = false;
+            if (!policy_.table_.empty())
+                return policy_.pickByTable(legal_actions, rng_);
+            return rng_.randrange(static_cast<int>(legal_actions.size()));
+        }
+    };
+
+    // action_weights[action]は行動actionの重み。表にない行動の重みは0とする
+    explicit RolloutPolicy(const std::vector<double> &action_weights = {})
+        : action_weights_(action_weights), table_(action_weights) {}
+
+    Picker picker(RandomGenerator &rng) const { return Picker(*this, rng); }
+};
+
+// ランダムに行動を決定する
+// action_weightsを渡すと、行動ごとの重みに比例して選ぶ
+inline std::vector<int> randomAction(std::shared_ptr<ContextualState> state, SearchMemoryStats *memory_stats = nullptr, const uint64_t seed = 0,
+                                     const std::vector<double> &action_weights = {})
+{
+    MemoryTracker memory(memory_stats);
+    RandomGenerator rng(seed);
+    const RolloutPolicy policy(action_weights);
+    std::vector<int> actions{};
+    auto end_state = randomRollout(
+        state,
+        policy.picker(rng),
+        [&](ContextualState &, const int action)
+        {
+            actions.emplace_back(action);
+            memory.recordFrontier(1);
+        });
+    if (end_state != state)
+        memory.track(*end_state);
+    memory.report();
+    return actions;
+}
+
+// 64bitのキーから値を引く開番地法のハッシュ表
+// 探索の内側で引くので、キーと値を連続したメモリに置いて線形探査する
+template <class Value>
+class FlatHashTable
+{
+private:
+    std::vector<uint64_t> keys_;
+    std::vector<Value> values_;
+    std::vector<uint8_t> used_;
+    std::size_t size_ = 0;
+    std::size_t mask_ = 0;
+
+    std::size_t slotOf(const uint64_t key) const
+    {
+        std::size_t slot = static_cast<std::size_t>(mixHash(key)) & mask_;
+        while (used_[slot] && keys_[slot] != key)
+            slot = (slot + 1) & mask_;
+        return slot;
+    }
+
+    void grow()
+    {
+        FlatHashTable grown(keys_.size() * 2);
+        for (std::size_t i = 0; i < keys_.size(); i++)
+            if (used_[i])
+                grown[keys_[i]] = std::move(values_[i]);
+        *this = std::move(grown);
+    }
+
+public:
+    // capacityは2の冪に切り上げる
+    explicit FlatHashTable(const std::size_t capacity = 16)
+    {
+        std::size_t size = 16;
+        while (size < capacity)
+            size <<= 1;
+        keys_.assign(size, 0);
+        values_.assign(size, Value());
+        used_.assign(size, 0);
+        mask_ = size - 1;
+    }
+
+    // キーがなければnullptrを返す
+    const Value *find(const uint64_t key) const
+    {
+        const std::size_t slot = slotOf(key);
+        return used_[slot] ? &values_[slot] : nullptr;
+    }
+
+    // キーがなければ既定値で挿入する。使用率が半分を超えたら容量を倍にする
+    Value &operator[](const uint64_t key)
+    {
+        std::size_t slot = slotOf(key);
+        if (!used_[slot])
+        {
+            if ((size_ + 1) * 2 > keys_.size())
+            {
+                grow();
+                slot = slotOf(key);
+            }
+            used_[slot] = 1;
+            keys_[slot] = key;
+            values_[slot] = Value(); // clearした後のスロットには前の値が残っている
+            size_++;
+        }
+        return values_[slot];
+    }
+
+    // キーを取り除く。後ろに続く要素を詰め直して、探索の列が途切れないようにする
+    void erase(const uint64_t key)
+    {
+        std::size_t hole = slotOf(key);
+        if (!used_[hole])
+            return;
+        for (std::size_t slot = (hole + 1) & mask_; used_[slot]; slot = (slot + 1) & mask_)
+        {
+            // 本来の位置からslotまでの間に穴があれば、穴へ移しても見つけられる
+            const std::size_t home = static_cast<std::size_t>(mixHash(keys_[slot])) & mask_;
+            if (((slot - home) & mask_) >= ((slot - hole) & mask_))
+            {
+                keys_[hole] = keys_[slot];
+                values_[hole] = std::move(values_[slot]);
+                hole = slot;
+            }
+        }
+        used_[hole] = 0;
+        values_[hole] = Value();
+        size_--;
+    }
+
+    std::size_t size() const { return size_; }
+
+    // 値は挿入するときに既定値へ戻すので、ここでは使用中の印だけ消す
+    void clear()
+    {
+        std::fill(used_.begin(), used_.end(), 0);
+        size_ = 0;
+    }
+};
+
+// d分木のヒープ。二分ヒープより浅く、取り出し時に比べる子が連続したメモリに並ぶ
+// compare(a, b)がtrueならaをbより先に取り出す
+template <class T, class Compare, std::size_t D = 4>
+class DaryHeap
+{
+private:
+    std::vector<T> data_;
+    Compare compare_;
+
+    void siftUp(std::size_t i)
+    {
+        T value = std::move(data_[i]);
+        while (i > 0)
+        {
+            const std::size_t parent = (i - 1) / D;
+            if (!compare_(value, data_[parent]))
+                break;
+            data_[i] = std::move(data_[parent]);
+            i = parent;
+        }
+        data_[i] = std::move(value);
+    }
+
+    void siftDown(std::size_t i)
+    {
+        T value = std::move(data_[i]);
+        while (true)
+        {
+            const std::size_t first = i * D + 1;
+            if (first >= data_.size())
+                break;
+            const std::size_t last = std::min(first + D, data_.size());
+            std::size_t best = first;
+            for (std::size_t child = first + 1; child < last; child++)
+                if (compare_(data_[child], data_[best]))
+                    best = child;
+            if (!compare_(data_[best], value))
+                break;
+            data_[i] = std::move(data_[best]);
+            i = best;
+        }
+        data_[i] = std::move(value);
+    }
+
+public:
+    explicit DaryHeap(Compare compare = Compare()) : compare_(compare) {}
+
+    bool empty() const { return data_.empty(); }
+    std::size_t size() const { return data_.size(); }
+    const T &top() const { return data_.front(); }
+
+    void push(T value)
+    {
+        data_.emplace_back(std::move(value));
+        siftUp(data_.size() - 1);
+    }
+
+    T pop()
+    {
+        T value = std::move(data_.front());
+        data_.front() = std::move(data_.back());
+        data_.pop_back();
+        if (!data_.empty())
+            siftDown(0);
+        return value;
+    }
+
+    // 先に取り出すkeep個だけを残し、残りをon_dropに渡して捨てる
+    template <class OnDrop>
+    void dropWorst(const std::size_t keep, OnDrop &&on_drop)
+    {
+        if (keep >= data_.size())
+            return;
+        std::nth_element(data_.begin(), data_.begin() + keep, data_.end(), compare_);
+        for (std::size_t i = keep; i < data_.size(); i++)
+            on_drop(data_[i]);
+        data_.resize(keep);
+        for (std::size_t i = data_.size() / D + 1; i-- > 0;)
+            if (i < data_.size())
+                siftDown(i);
+    }
+};
+
+// 行動列と、それで到達した終わりの状態の評価値
+struct RolloutResult
+{
+    std::vector<int> actions;
+    double score = -std::numeric_limits<double>::infinity();
+};
+
+// プレイアウトを終えた状態の評価値。合法でない状態は最も悪い値にする
+inline double rolloutScore(ContextualState &state)
+{
+    return state.is_dead() ? -std::numeric_limits<double>::infinity() : state.evaluate_score();
+}
+
+// ビームスタックサーチで層の中の状態を並べる順序
+// 評価値が高いほど、同じ評価値なら生成順が早いほど良い。生成順で全順序にして層を重複なく区切る
+struct BeamStackKey
+{
+    double score;
+    long long ordinal;
+
+    bool betterThan(const BeamStackKey &other) const
+    {
+        return score > other.score || (score == other.score && ordinal < other.ordinal);
+    }
+};
+
+// ビームスタックサーチ
+// 各層で良い順にbeam_width個だけ残し、残した中で最も悪い順位をスタックに積んでおく
+// 下の層を調べ尽くしたら、枝刈りした続きの順位からその層を作り直して探索を続けるので、
+// 深さが有限なら全ての状態を調べて必ず終了する。使うメモリは深さ×ビーム幅で抑えられる
+// max_depthを渡すとその深さより下は展開しないので、深さに上限のない問題でも終了する
+// score_boundのときは評価値をそこから先で得られる評価値の上限とみなし、
+// 見つけた終了状態より良くならない子と、そういう子しか残っていない層の作り直しを省く
+class BeamStackSearcher
+{
+public:
+    using ImproveCallback = std::function<void(const std::vector<int> &, double)>;
+
+private:
+    struct Candidate
+    {
+        std::shared_ptr<ContextualState> state;
+        BeamStackKey key;
+    };
+
+    struct Layer
+    {
+        std::vector<Candidate> nodes; // 良い順
+        bool complete = true;         // 枝刈りした状態が残っていないか
+    };
+
+    int beam_width_;
+    int max_depth_;
+    bool score_bound_;
+    TimeKeeper time_keeper_;
+    ImproveCallback on_improve_;
+    EvaluationCache *cache_;
+    std::shared_ptr<ContextualState> best_state_ = nullptr;    // 見つけた中で最も良い終了状態
+    std::shared_ptr<ContextualState> best_partial_ = nullptr;  // 終了状態が見つからないときに返す状態
+    ActionBuffer legal_actions_;
+    StepResult step_;
+    SearchProfiler profiler_;
+
+    std::vector<int> finish(const std::shared_ptr<ContextualState> &state)
+    {
+        auto actions = actionsTo(state);
+        profiler_.finish(actions, state->evaluated_score_);
+        return actions;
+    }
+
+    // score_boundのとき、scoreの状態から見つけた終了状態より良くなることがないか
+    bool cannotImprove(const double score) const
+    {
+        return score_bound_ && best_state_ != nullptr && score <= best_state_->evaluated_score_;
+    }
+
+    void updateBest(const std::shared_ptr<ContextualState> &state)
+    {
+        if (best_state_ != nullptr && !(best_state_ < state))
+            return;
+        best_state_ = state;
+        if (on_improve_)
+            on_improve_(actionsTo(state), state->evaluated_score_);
+    }
+
+    // layerの状態を全て展開し、順位がboundより悪い子のうち良い順にbeam_width_個で次の層をつくる
+    // 親の層が同じなら子の生成順も同じなので、作り直しても同じ順位がつく
+    // depthは子の深さで、統計にだけ使う
+    Layer expand(const Layer &layer, const BeamStackKey *bound, const int depth)
+    {
+        std::vector<Candidate> candidates;
+        long long ordinal = 0;
+        for (const auto &node : layer.nodes)
+        {
+            expandChildren(*node.state, depth - 1, cache_, false, legal_actions_, step_, profiler_, nullptr, [&](StepResult &child)
+                           {
+                               const long long child_ordinal = ordinal++;
+                               auto next_state = std::move(child.state);
+                               if (child.done)
+                               {
+                                   updateBest(next_state);
+                                   return;
+                               }
+                               const BeamStackKey key{next_state->evaluated_score_, child_ordinal};
+                               if (bound != nullptr && !bound->betterThan(key))
+                                   return;
+                               if (cannotImprove(key.score))
+                               {
+                                   profiler_.stats.pruned_beam++;
+                                   return;
+                               }
+                               candidates.push_back(Candidate{next_state, key}); });
+        }
+
+        const auto better = [](const Candidate &a, const Candidate &b)
+        { return a.key.betterThan(b.key); };
+        Layer next_layer;
+        next_layer.complete = static_cast<int>(candidates.size()) <= beam_width_;
+        if (next_layer.complete)
+        {
+            std::sort(candidates.begin(), candidates.end(), better);
+        }
+        else
+        {
+            std::partial_sort(candidates.begin(), candidates.begin() + beam_width_, candidates.end(), better);
+            profiler_.stats.pruned_beam += static_cast<long long>(candidates.size()) - beam_width_;
+            candidates.resize(beam_width_);
+        }
+        next_layer.nodes = std::move(candidates);
+        if (!next_layer.nodes.empty() && (best_partial_ == nullptr || best_partial_ < next_layer.nodes.front().state))
+            best_partial_ = next_layer.nodes.front().state;
+        return next_layer;
+    }
+
+public:
+    BeamStackSearcher(const int beam_width, const int64_t time_limit, ImproveCallback on_improve, EvaluationCache *cache,
+                      SearchResult *result, const int max_depth = 0, const bool score_bound = false)
+        : beam_width_(beam_width), max_depth_(max_depth), score_bound_(score_bound), time_keeper_(time_limit), on_improve_(std::move(on_improve)), cache_(cache), profiler_(result) {}
+
+    // 時間切れになったら、それまでに見つけた最も良い終了状態までの行動列を返す
+    std::vector<int> search(const std::shared_ptr<ContextualState> &state)
+    {
+        std::vector<Layer> stack(1);
+        stack[0].nodes.push_back(Candidate{state, BeamStackKey{0, 0}});
+        while (!stack.empty() && !time_keeper_.isTimeOver())
+        {
+            // stack.back()の深さはstack.size() - 1
+            Layer next_layer;
+            if (max_depth_ <= 0 || static_cast<int>(stack.size()) <= max_depth_)
+                next_layer = expand(stack.back(), nullptr, static_cast<int>(stack.size()));
+            if (!next_layer.nodes.empty())
+            {
+                stack.push_back(std::move(next_layer));
+                continue;
+            }
+            // 下の層がなくなったので、枝刈りした状態が残っている一番深い層まで戻って作り直す
+            while (!stack.empty())
+            {
+                // 枝刈りした状態はどれも残した最も悪い状態より評価値が高くない
+                if (stack.back().complete || cannotImprove(stack.back().nodes.back().key.score))
+                {
+                    stack.pop_back();
+                    continue;
+                }
+                const BeamStackKey bound = stack.back().nodes.back().key;
+                stack.back() = expand(stack[stack.size() - 2], &bound, static_cast<int>(stack.size()) - 1);
+                if (stack.back().nodes.empty())
+                {
+                    stack.pop_back();
+                    continue;
+                }
+                break;
+            }
+        }
+        if (best_state_ != nullptr)
+            return finish(best_state_);
+        if (best_partial_ != nullptr)
+            return finish(best_partial_);
+        profiler_.finish(std::vector<int>{}, 0);
+        return std::vector<int>{};
+    }
+};
+
+// ビームスタックサーチで行動を決定する
+// on_improveを渡すと、より良い終了状態を見つけるたびに行動列と評価値を渡して呼ぶ
+inline std::vector<int> beamStackSearchAction(std::shared_ptr<ContextualState> state, const int beam_width, const int64_t time_limit,
+                                              BeamStackSearcher::ImproveCallback on_improve, EvaluationCache *cache, SearchResult *result,
+                                              const int max_depth = 0, const bool score_bound = false)
+{
+    if (beam_width < 1)
+        throw std::invalid_argument("beam_width must be positive");
+    BeamStackSearcher searcher(beam_width, time_limit, std::move(on_improve), cache, result, max_depth, score_bound);
+    return searcher.search(state);
+}
+
+// ターンごとに呼ばれるビームサーチのセッション
+// 評価値のキャッシュ、同じ層の重複を除く置換表、候補や合法手のバッファを呼び出しをまたいで持ち続ける
+// 前回の探索の各層も残しておき、新しい根が前回のどこかの層の状態と同じハッシュ値なら、
+// その状態の子孫を新しい探索の対応する層に種として加え、前回見つけた終了状態もその子孫なら候補に残す
+// 状態の同一性はhash()だけで判断するので、ハッシュ値が衝突すると別の状態の子孫を引き継いでしまう
+// 行動列はセッションが持つ経路の節から復元し、状態のparent_は使わない
+// ビームサーチは1スレッドで動き、状態はshared_ptrで持つので、スレッドプールやアリーナは持たない
+class SearchSession
+{
+private:
+    // 根からの経路の節。引き継いだ状態の経路は、前回の状態を書き換えずに新しい根から作り直す
+    struct PathNode
+    {
+        std::shared_ptr<const PathNode> parent; // 根の子ならnullptr
+        int action;
+    };
+    using Path = std::shared_ptr<const PathNode>;
+
+    struct Entry
+    {
+        std::shared_ptr<ContextualState> state;
+        uint64_t hash;
+        Path path;  // 根ならnullptr
+        int action; // 0以上なら、pathは親の経路で、この行動の節をまだ足していない
+    };
+
+    int beam_width_;
+    EvaluationCache cache_;
+    FlatHashTable<char> seen_;               // 今の層に入れた状態のハッシュ値
+    std::vector<std::vector<Entry>> layers_; // 前回の探索で各層に残した状態。layers_[0]は根
+    Entry best_done_{nullptr, 0, nullptr, -1}; // 前回見つけた最良の終了状態
+    int best_done_depth_ = 0;
+    std::vector<Entry> candidates_;
+    ActionBuffer legal_actions_;
+    StepResult step_;
+    long long reused_states_ = 0;
+
+    static uint64_t keyOf(const PathNode *node) { return static_cast<uint64_t>(reinterpret_cast<uintptr_t>(node)); }
+
+    // 節の生成はビームに残った状態の分だけで済ませる
+    static void completePath(Entry &entry)
+    {
+        if (entry.action < 0)
+            return;
+        entry.path = std::make_shared<const PathNode>(PathNode{entry.path, entry.action});
+        entry.action = -1;
+    }
+
+    static std::vector<int> actionsOf(const Entry &entry)
+    {
+        std::vector<int> actions;
+        if (entry.action >= 0)
+            actions.push_back(entry.action);
+        for (const PathNode *node = entry.path.get(); node != nullptr; node = node->parent.get())
+            actions.push_back(node->action);
+        std::reverse(actions.begin(), actions.end());
+        return actions;
+    }
+
+    // pathがancestorのsteps段下なら、ancestorを根とする経路に作り直してrerootedに書き込む
+    // 作り直した節はmemoに残し、兄弟で共有する
+    static bool reroot(const Path &path, const int steps, const PathNode *ancestor, FlatHashTable<Path> &memo, Path &rerooted)
+    {
+        if (steps == 0)
+        {
+            rerooted = nullptr;
+            return path.get() == ancestor;
+        }
+        if (path == nullptr)
+            return false;
+        if (const Path *known = memo.find(keyOf(path.get())))
+        {
+            rerooted = *known;
+            return true;
+        }
+        Path parent;
+        if (!reroot(path->parent, steps - 1, ancestor, memo, parent))
+            return false;
+        rerooted = std::make_shared<const PathNode>(PathNode{parent, path->action});
+        memo[keyOf(path.get())] = rerooted;
+        return true;
+    }
+
+    // 新しい根と同じ状態を前回の層から探し、その子孫を新しい深さごとに返す
+    // 子孫の経路は見つかった状態を根として作り直すので、行動列は新しい根から復元される
+    std::vector<std::vector<Entry>> reuse(const uint64_t root_hash, Entry &incumbent)
+    {
+        std::vector<std::vector<Entry>> seeds;
+        for (std::size_t depth = 1; depth < layers_.size(); depth++)
+        {
+            const Entry *match = nullptr;
+            for (const auto &entry : layers_[depth])
+            {
+                if (entry.hash == root_hash)
+                {
+                    match = &entry;
+                    break;
+                }
+            }
+            if (match == nullptr)
+                continue;
+
+            const PathNode *matched = match->path.get();
+            FlatHashTable<Path> memo;
+            Path path;
+            seeds.resize(layers_.size() - depth);
+            for (std::size_t d = depth + 1; d < layers_.size(); d++)
+            {
+                for (const auto &entry : layers_[d])
+                {
+                    if (reroot(entry.path, static_cast<int>(d - depth), matched, memo, path))
+                        seeds[d - depth].push_back(Entry{entry.state, entry.hash, path, -1});
+                }
+            }
+            if (best_done_.state != nullptr && best_done_depth_ > static_cast<int>(depth) &&
+                reroot(best_done_.path, best_done_depth_ - static_cast<int>(depth), matched, memo, path))
+                incumbent = Entry{best_done_.state, best_done_.hash, path, -1};
+            for (const auto &layer : seeds)
+                reused_states_ += static_cast<long long>(layer.size());
+            break;
+        }
+        return seeds;
+    }
+
+public:
+    SearchSession(const int beam_width, const std::size_t cache_capacity, const int ways)
+        : beam_width_(beam_width), cache_(cache_capacity, ways)
+    {
+        if (beam_width < 1)
+            throw std::invalid_argument("beam_width must be positive");
+    }
+
+    EvaluationCache &cache() { return cache_; }
+
+    // 直前のsearchで前回の探索から引き継いだ状態の数
+    long long reusedStates() const { return reused_states_; }
+
+    // 前回の探索を捨てる。キャッシュも空にする
+    void reset()
+    {
+        layers_.clear();
+        best_done_ = Entry{nullptr, 0, nullptr, -1};
+        best_done_depth_ = 0;
+        cache_.clear();
+    }
+
+    // ビームサーチで行動を決定する
+    // 子はビームサーチと同じくexpandChildrenでつくる。重複を除くためにhash()を求めるので、評価値はキャッシュから引く
+    std::vector<int> search(std::shared_ptr<ContextualState> root, SearchResult *result)
+    {
+        SearchProfiler profiler(result);
+        reused_states_ = 0;
+        uint64_t root_hash;
+        {
+            SearchProfiler::CallbackScope scope(profiler);
+            TraceScope trace("hash");
+            root_hash = root->hash();
+        }
+        Entry incumbent{nullptr, 0, nullptr, -1};
+        auto seeds = reuse(root_hash, incumbent);
+        layers_.clear();
+        best_done_ = Entry{nullptr, 0, nullptr, -1};
+
+        const auto better = [](const Entry &a, const Entry &b)
+        { return a.state->evaluated_score_ > b.state->evaluated_score_; };
+        Entry best{nullptr, 0, nullptr, -1};
+        bool found_done = false;
+        layers_.push_back({Entry{root, root_hash, nullptr, -1}});
+        for (std::size_t t = 0;; t++)
+        {
+            seen_.clear();
+            candidates_.clear();
+            if (t + 1 < seeds.size())
+            {
+                for (const auto &entry : seeds[t + 1])
+                {
+                    seen_[entry.hash] = 1;
+                    candidates_.push_back(entry);
+                }
+            }
+            for (const auto &entry : layers_[t])
+            {
+                expandChildren(*entry.state, static_cast<int>(t), &cache_, true, legal_actions_, step_, profiler, nullptr, [&](StepResult &child)
+                               {
+                                   if (seen_.find(child.hash) != nullptr)
+                                   {
+                                       profiler.stats.pruned_duplicate++;
+                                       child.state = nullptr;
+                                       return;
+                                   }
+                                   seen_[child.hash] = 1;
+                                   // 経路は節で持つので、親へのリンクを切って残した層の状態だけを生かしておく
+                                   child.state->parent_ = nullptr;
+                                   const int action = child.state->last_action_;
+                                   Entry next{std::move(child.state), child.hash, entry.path, action};
+                                   if (child.done)
+                                   {
+                                       if (best.state == nullptr || best.state < next.state)
+                                           best = std::move(next);
+                                       return;
+                                   }
+                                   candidates_.push_back(std::move(next)); });
+            }
+
+            found_done = best.state != nullptr;
+            if (found_done)
+                break;
+            // 終了状態に届かないまま候補がなくなったら、最後の層で最も良い状態までの行動列を返す
+            if (candidates_.empty())
+            {
+                const auto &layer = layers_[t];
+                if (t > 0)
+                    best = *std::min_element(layer.begin(), layer.end(), better);
+                break;
+            }
+            if (static_cast<int>(candidates_.size()) > beam_width_)
+            {
+                std::partial_sort(candidates_.begin(), candidates_.begin() + beam_width_, candidates_.end(), better);
+                profiler.stats.pruned_beam += static_cast<long long>(candidates_.size()) - beam_width_;
+                candidates_.resize(beam_width_);
+            }
+            else
+            {
+                std::sort(candidates_.begin(), candidates_.end(), better);
+            }
+            for (auto &candidate : candidates_)
+                completePath(candidate);
+            layers_.push_back(candidates_);
+        }
+
+        if (incumbent.state != nullptr && (!found_done || best.state < incumbent.state))
+        {
+            best = incumbent;
+            found_done = true;
+        }
+        if (best.state == nullptr)
+        {
+            profiler.finish(std::vector<int>{}, 0);
+            return std::vector<int>{};
+        }
+        auto actions = actionsOf(best);
+        if (found_done)
+        {
+            completePath(best);
+            best_done_ = best;
+            best_done_depth_ = static_cast<int>(actions.size());
+        }
+        profiler.finish(actions, best.state->evaluated_score_);
+        return actions;
+    }
+};
+
+// 重み付きA*による最良優先探索
+// 開始状態からのコストg(step_costの和)と残りコストの見積もりh(heuristic)から、
+// f = g + weight * hが小さい状態から展開し、最初に取り出した終了状態までの行動列を返す
+// hが過大に見積もらなければ、weightが1のとき最小コストの行動列になる
+// 同じhash()の状態はgが小さくなるときだけ開き直す
+// 記憶する状態は、未展開の状態と、子を記憶している展開済みの状態(経路の復元に要る祖先)に限り、合わせてnode_limitまでにする
+// 超えたらfが大きい未展開の状態から捨てて親に書き戻し、子が全てなくなった親は書き戻したfで開き直す(SMA*の要領)
+// 捨てた状態はハッシュ値も忘れるので、後で作り直せる
+class BestFirstSearcher
+{
+private:
+    // 生成した状態と、展開元をたどる記録
+    // 親の状態にもPython側のメソッドを呼ぶので、parent_ではなくこの記録で親を生かしておく
+    struct Record
+    {
+        double g;
+        double f;
+        uint64_t hash;
+        int action; // 親からの行動
+        std::shared_ptr<ContextualState> state;
+        std::shared_ptr<Record> parent;
+        int children;     // 記憶している子の数
+        double dropped_f; // 捨てた子の中で最小のf
+    };
+    using RecordPtr = std::shared_ptr<Record>;
+
+    struct Node
+    {
+        double f;
+        RecordPtr record;
+    };
+
+    // fが小さい順、同じならgが大きい(終了状態に近い)順に取り出す
+    struct NodeOrder
+    {
+        bool operator()(const Node &a, const Node &b) const
+        {
+            return a.f < b.f || (a.f == b.f && a.record->g > b.record->g);
+        }
+    };
+
+    double weight_;
+    std::size_t node_limit_;
+    TimeKeeper time_keeper_;
+    DaryHeap<Node, NodeOrder> open_;
+    FlatHashTable<double> best_g_; // 記憶している状態のハッシュ値ごとの最小のg
+    std::size_t stored_ = 0;       // 記憶している状態の数
+    std::vector<int> closest_actions_; // 終了状態が見つからないときに返す、hが最小の状態までの行動列
+    double closest_h_ = std::numeric_limits<double>::infinity();
+    ActionBuffer legal_actions_;
+    std::vector<Node> dropped_;
+
+    static std::vector<int> actionsOf(const Record *record)
+    {
+        std::vector<int> actions;
+        for (; record->parent != nullptr; record = record->parent.get())
+            actions.push_back(record->action);
+        std::reverse(actions.begin(), actions.end());
+        return actions;
+    }
+
+    void open(const double g, const uint64_t hash, const int action, std::shared_ptr<ContextualState> state, const RecordPtr &parent)
+    {
+        const double h = state->heuristic();
+        auto record = std::make_shared<Record>(Record{g, g + weight_ * h, hash, action, std::move(state), parent, 0,
+                                                      std::numeric_limits<double>::infinity()});
+        if (h < closest_h_)
+        {
+            closest_h_ = h;
+            closest_actions_ = actionsOf(record.get());
+        }
+        if (parent != nullptr)
+            parent->children++;
+        best_g_[hash] = g;
+        stored_++;
+        const double f = record->f;
+        open_.push(Node{f, std::move(record)});
+    }
+
+    // 記録を記憶から外し、fを親に書き戻す。この記録が最小のgを持っていればハッシュ値も忘れる
+    // 同じ状態がより小さいgで見つかっている古い記録は、best_g_に触れない
+    // 親の子がなくなったら、親を未展開に戻して書き戻したfで開き直す
+    void release(const RecordPtr &record, const double f)
+    {
+        stored_--;
+        const double *known_g = best_g_.find(record->hash);
+        if (known_g != nullptr && *known_g == record->g)
+            best_g_.erase(record->hash);
+        const RecordPtr &parent = record->parent;
+        if (parent == nullptr)
+            return;
+        parent->dropped_f = std::min(parent->dropped_f, f);
+        if (--parent->children > 0)
+            return;
+        const double reopened_f = std::max(parent->f, parent->dropped_f);
+        parent->dropped_f = std::numeric_limits<double>::infinity();
+        open_.push(Node{reopened_f, parent});
+    }
+
+    // 記憶している状態を4分の3まで減らす。fが大きい未展開の状態から捨て、開き直した親も捨てる対象にする
+    void dropWorst()
+    {
+        const std::size_t keep = node_limit_ - node_limit_ / 4 - 1;
+        while (stored_ > keep && open_.size() > 1)
+        {
+            const std::size_t excess = std::min(stored_ - keep, open_.size() - 1);
+            dropped_.clear();
+            open_.dropWorst(open_.size() - excess, [&](const Node &node)
+                            { dropped_.push_back(node); });
+            for (const auto &node : dropped_)
+                release(node.record, node.f);
+        }
+        dropped_.clear();
+    }
+
+public:
+    BestFirstSearcher(const double weight, const int node_limit, const int64_t time_limit)
+        : weight_(weight), node_limit_(static_cast<std::size_t>(node_limit)), time_keeper_(time_limit)
+    {
+        if (node_limit < 4)
+            throw std::invalid_argument("node_limit must be at least 4");
+    }
+
+    std::vector<int> search(const std::shared_ptr<ContextualState> &state)
+    {
+        open(0, state->hash(), -1, state, nullptr);
+        while (!open_.empty() && !time_keeper_.isTimeOver())
+        {
+            const Node node = open_.pop();
+            // 子が合法でないか、より良い経路で見つかっている状態しか残っていない
+            if (node.f == std::numeric_limits<double>::infinity())
+                break;
+            const RecordPtr &record = node.record;
+            const double *best_g = best_g_.find(record->hash);
+            if (best_g != nullptr && *best_g < record->g)
+            {
+                release(record, std::numeric_limits<double>::infinity());
+                continue;
+            }
+            if (record->state->is_done())
+                return actionsOf(record.get());
+
+            record->state->legal_actions_into(legal_actions_);
+            for (const int action : legal_actions_)
+            {
+                const double g = record->g + record->state->step_cost(action);
+                auto next_state = record->state->cloneAdvanced(action);
+                next_state->parent_ = nullptr;
+                if (next_state->is_dead())
+                    continue;
+                const uint64_t key = next_state->hash();
+                const double *known_g = best_g_.find(key);
+                if (known_g != nullptr && *known_g <= g)
+                    continue;
+                open(g, key, action, std::move(next_state), record);
+            }
+            if (record->children == 0)
+                release(record, std::numeric_limits<double>::infinity());
+            if (stored_ > node_limit_)
+                dropWorst();
+        }
+        return closest_actions_;
+    }
+};
+
+// 重み付きA*で行動を決定する
+inline std::vector<int> bestFirstAction(std::shared_ptr<ContextualState> state, const double weight, const int node_limit, const int64_t time_limit)
+{
+    if (weight < 0)
+        throw std::invalid_argument("weight must not be negative");
+    BestFirstSearcher searcher(weight, node_limit, time_limit);
+    return searcher.search(state);
+}
+
+// 入れ子モンテカルロ探索(Nested Monte Carlo Search)
+// 各手でそれぞれの行動の後に1つ低いレベルの探索をして、見つけた最良の行動列に沿って進む
+class NestedMonteCarloSearcher
+{
+private:
+    RandomGenerator rng_;
+    TimeKeeper time_keeper_;
+    RolloutPolicy policy_;
+
+    RolloutResult playout(const std::shared_ptr<ContextualState> &state)
+    {
+        RolloutResult result;
+        auto end_state = randomRollout(
+            state,
+            policy_.picker(rng_),
+            [&](ContextualState &, const int action)
+            { result.actions.emplace_back(action); });
+        result.score = rolloutScore(*end_state);
+        return result;
+    }
+
+public:
+    NestedMonteCarloSearcher(const uint64_t seed, const int64_t time_limit, const std::vector<double> &action_weights)
+        : rng_(seed), time_keeper_(time_limit), policy_(action_weights) {}
+
+    // 時間切れになったら、それまでに見つけた最良の行動列を返す
+    RolloutResult search(std::shared_ptr<ContextualState> state, const int level)
+    {
+        if (level == 0)
+            return playout(state);
+        RolloutResult best;
+        bool has_best = false;
+        std::vector<int> played;
+        ActionBuffer legal_actions;
+        while (!isRolloutEnd(*state))
+        {
+            state->legal_actions_into(legal_actions);
+            if (legal_actions.empty())
+                break;
+            for (const int action : legal_actions)
+            {
+                if (has_best && time_keeper_.isTimeOver())
+                    break;
+                auto result = search(state->cloneAdvanced(action), level - 1);
+                if (!has_best || result.score > best.score)
+                {
+                    best.score = result.score;
+                    best.actions = played;
+                    best.actions.emplace_back(action);
+                    best.actions.insert(best.actions.end(), result.actions.begin(), result.actions.end());
+                    has_best = true;
+                }
+            }
+            // 最良の行動列は今の状態を通るので、その続きの1手を指す
+            const int action = best.actions[played.size()];
+            played.emplace_back(action);
+            state = state->cloneAdvanced(action);
+            if (time_keeper_.isTimeOver())
+                break;
+        }
+        if (!has_best)
+        {
+            best.actions = played;
+            best.score = rolloutScore(*state);
+        }
+        return best;
+    }
+};
+
+// 入れ子モンテカルロ探索で行動を決定する
+inline std::vector<int> nestedMonteCarloAction(std::shared_ptr<ContextualState> state, const int level, const int64_t time_limit, const uint64_t seed,
+                                               const std::vector<double> &action_weights)
+{
+    if (level < 1)
+        throw std::invalid_argument("level must be positive");
+    NestedMonteCarloSearcher searcher(seed, time_limit, action_weights);
+    return searcher.search(state, level).actions;
+}
+
+// 入れ子ロールアウト方策適応(Nested Rollout Policy Adaptation)
+// レベル0では方策の重みに比例した確率で行動を選んでプレイアウトし、
+// 上のレベルでは見つけた最良の行動列を選びやすくなるよう方策を学習する
+class NrpaSearcher
+{
+private:
+    using Policy = FlatHashTable<double>;
+
+    // プレイアウトの行動列と、各手の合法手
+    // t手目の合法手はlegal_actions[legal_offsets[t], legal_offsets[t + 1])
+    struct Playout
+    {
+        RolloutResult result;
+        std::vector<int> legal_offsets;
+        std::vector<int> legal_actions;
+    };
+
+    RandomGenerator rng_;
+    TimeKeeper time_keeper_;
+    int iterations_;
+    double alpha_;
+    std::vector<double> weights_;
+
+    // 手数と行動を混ぜて方策のキーにする
+    static uint64_t actionCode(const int depth, const int action)
+    {
+        return (static_cast<uint64_t>(depth) << 32) ^ static_cast<uint32_t>(action);
+    }
+
+    static double weight(const Policy &policy, const uint64_t code)
+    {
+        const double *found = policy.find(code);
+        return found == nullptr ? 0. : *found;
+    }
+
+    // 各行動のexp(重み)を、最大の重みを引いてあふれないように求めて合計を返す
+    double softmaxWeights(const Policy &policy, const int depth, const int *actions, const int count)
+    {
+        weights_.resize(count);
+        double max_weight = -std::numeric_limits<double>::infinity();
+        for (int i = 0; i < count; i++)
+        {
+            weights_[i] = weight(policy, actionCode(depth, actions[i]));
+            max_weight = std::max(max_weight, weights_[i]);
+        }
+        double sum = 0;
+        for (auto &w : weights_)
+        {
+            w = std::exp(w - max_weight);
+            sum += w;
+        }
+        return sum;
+    }
+
+    // randomRolloutと同じく、始めに1度だけ複製してその場で進める
+    Playout playout(std::shared_ptr<ContextualState> state, const Policy &policy)
+    {
+        Playout playout;
+        ActionBuffer legal_actions;
+        if (!isRolloutEnd(*state))
+            state = state->clone();
+        while (!isRolloutEnd(*state))
+        {
+            state->legal_actions_into(legal_actions);
+            if (legal_actions.empty())
+                break;
+            const int depth = static_cast<int>(playout.result.actions.size());
+            const int count = static_cast<int>(legal_actions.size());
+            playout.legal_offsets.emplace_back(static_cast<int>(playout.legal_actions.size()));
+            playout.legal_actions.insert(playout.legal_actions.end(), legal_actions.begin(), legal_actions.end());
+
+            double r = rng_.random() * softmaxWeights(policy, depth, legal_actions.begin(), count);
+            int chosen = count - 1;
+            for (int i = 0; i < count; i++)
+            {
+                r -= weights_[i];
+                if (r < 0)
+                {
+                    chosen = i;
+                    break;
+                }
+            }
+            playout.result.actions.emplace_back(legal_actions[chosen]);
+            state->advance(legal_actions[chosen]);
+        }
+        playout.legal_offsets.emplace_back(static_cast<int>(playout.legal_actions.size()));
+        playout.result.score = rolloutScore(*state);
+        return playout;
+    }
+
+    // 最良の行動列の確率が上がる方向へ、方策の対数尤度の勾配でalpha_だけ進める
+    void adapt(Policy &policy, const Playout &best)
+    {
+        const Policy old_policy = policy;
+        for (int depth = 0; depth < static_cast<int>(best.result.actions.size()); depth++)
+        {
+            const int begin = best.legal_offsets[depth];
+            const int count = best.legal_offsets[depth + 1] - begin;
+            const int *actions = best.legal_actions.data() + begin;
+            const double sum = softmaxWeights(old_policy, depth, actions, count);
+            policy[actionCode(depth, best.result.actions[depth])] += alpha_;
+            for (int i = 0; i < count; i++)
+                policy[actionCode(depth, actions[i])] -= alpha_ * weights_[i] / sum;
+        }
+    }
+
+public:
+    NrpaSearcher(const uint64_t seed, const int64_t time_limit, const int iterations, const double alpha)
+        : rng_(seed), time_keeper_(time_limit), iterations_(iterations), alpha_(alpha) {}
+
+    // 方策は値渡しで受け取り、レベルごとに独立に学習する
+    Playout search(const std::shared_ptr<ContextualState> &state, const int level, Policy policy)
+    {
+        if (level == 0)
+            return playout(state, policy);
+        Playout best;
+        bool has_best = false;
+        for (int i = 0; i < iterations_; i++)
+        {
+            if (has_best && time_keeper_.isTimeOver())
+                break;
+            auto result = search(state, level - 1, policy);
+            if (!has_best || result.result.score >= best.result.score)
+            {
+                best = std::move(result);
+                has_best = true;
+            }
+            adapt(policy, best);
+        }
+        return best;
+    }
+};
+
+// 入れ子ロールアウト方策適応で行動を決定する
+inline std::vector<int> nrpaAction(std::shared_ptr<ContextualState> state, const int level, const int iterations, const double alpha, const int64_t time_limit,
+                                   const uint64_t seed)
+{
+    if (level < 1)
+        throw std::invalid_argument("level must be positive");
+    if (iterations < 1)
+        throw std::invalid_argument("iterations must be positive");
+    NrpaSearcher searcher(seed, time_limit, iterations, alpha);
+    return searcher.search(state, level, FlatHashTable<double>()).result.actions;
+}
+
+class NonContextualState : public std::enable_shared_from_this<NonContextualState>
+{
+public:
+    double evaluated_score_ = 0; // 探索上で評価したスコア
+
+    virtual ~NonContextualState() {}
+    virtual std::shared_ptr<NonContextualState> clone() const = 0;
+
+    // 近傍への遷移を1つ選び、その識別子を返す。状態は変更しない
+    virtual int neighbor(RandomGenerator &rng) = 0;
+
+    // neighborで選んだ遷移を適用する
+    virtual void transition(const int move) = 0;
+
+    // 探索用の盤面評価をする
+    virtual double evaluate_score() = 0;
+
+    // delta_scoreを実装しているか
+    virtual bool has_delta_score() { return false; }
+
+    // 遷移を適用した場合の評価値の変化量を、状態を変更せずに返す
+    // 実装されていれば棄却される遷移のために状態を複製しなくて済む
+    virtual double delta_score(const int /* move */)
+    {
+        throw std::logic_error("delta_score is not implemented");
+    }
+
+    // 今の状態から選べる遷移を全て返す。近傍を全て調べる探索だけが使う
+    virtual std::vector<int> _neighborhood()
+    {
+        throw std::logic_error("neighborhood is not implemented");
+    }
+
+    // 呼び出し側が使い回すバッファに近傍の遷移を書き込む
+    virtual void neighborhood_into(ActionBuffer &buffer)
+    {
+        auto moves = _neighborhood();
+        buffer.assign(moves.begin(), moves.end());
+    }
+
+    // 遷移の属性。タブーサーチは適用した遷移の属性をしばらく禁止する
+    virtual uint64_t move_attribute(const int move) { return static_cast<uint32_t>(move); }
+};
+
+// 反復回数と制限時間(ミリ秒)の少なくとも一方が指定されているか確かめる
+inline void checkSearchLimit(const int64_t iterations, const int64_t time_limit)
+{
+    if (iterations <= 0 && time_limit <= 0)
+        throw std::invalid_argument("either iterations or time_limit must be positive");
+}
+
+// 山登り法で状態を改善する
+// iterationsが0以下なら反復回数、time_limitが0以下なら時間で打ち切らない
+inline std::shared_ptr<NonContextualState> hillClimb(std::shared_ptr<NonContextualState> state, const int64_t iterations, const int64_t time_limit, const uint64_t seed)
+{
+    checkSearchLimit(iterations, time_limit);
+    RandomGenerator rng(seed);
+    TimeKeeper time_keeper(time_limit);
+
+    auto now_state = state->clone();
+    now_state->evaluated_score_ = now_state->evaluate_score();
+    const bool use_delta_score = now_state->has_delta_score();
+
+    for (int64_t i = 0; iterations <= 0 || i < iterations; i++)
+    {
+        if (time_keeper.isTimeOver())
+            break;
+        const int move = now_state->neighbor(rng);
+        if (use_delta_score)
+        {
+            // 変化量だけで採否を決めるので、棄却する遷移では複製も遷移も起きない
+            const double delta = now_state->delta_score(move);
+            if (delta > 0)
+            {
+                now_state->transition(move);
+                now_state->evaluated_score_ += delta;
+            }
+            continue;
+        }
+        auto next_state = now_state->clone();
+        next_state->transition(move);
+        next_state->evaluated_score_ = next_state->evaluate_score();
+        if (next_state->evaluated_score_ > now_state->evaluated_score_)
+        {
+            now_state = next_state;
+        }
+    }
+    // 変化量の積み重ねによる誤差を残さないように評価し直す
+    now_state->evaluated_score_ = now_state->evaluate_score();
+    return now_state;
+}
+
+// タブーサーチで状態を改善する
+// 毎回近傍を全て評価して、禁止されていない中で最も良い遷移を(悪くなる場合も)適用する
+// 適用した遷移の属性はtenure回の反復の間禁止するが、これまでの最良を更新する遷移は禁止中でも選ぶ(aspiration)
+// 属性ごとの禁止が解ける反復をFlatHashTableに持つので、禁止の判定は定数時間でできる
+inline std::shared_ptr<NonContextualState> tabuSearch(std::shared_ptr<NonContextualState> state, const int64_t iterations, const int64_t time_limit, const int tenure)
+{
+    checkSearchLimit(iterations, time_limit);
+    if (tenure < 0)
+        throw std::invalid_argument("tenure must not be negative");
+    TimeKeeper time_keeper(time_limit);
+    FlatHashTable<int64_t> tabu_until;
+    ActionBuffer moves;
+
+    auto now_state = state->clone();
+    now_state->evaluated_score_ = now_state->evaluate_score();
+    auto best_state = now_state->clone();
+    best_state->evaluated_score_ = now_state->evaluated_score_;
+    const bool use_delta_score = now_state->has_delta_score();
+
+    for (int64_t i = 0; iterations <= 0 || i < iterations; i++)
+    {
+        if (time_keeper.isTimeOver())
+            break;
+        now_state->neighborhood_into(moves);
+        bool found = false;
+        int chosen_move = 0;
+        uint64_t chosen_attribute = 0;
+        double chosen_score = -std::numeric_limits<double>::infinity();
+        std::shared_ptr<NonContextualState> chosen_state = nullptr; // delta_scoreがないときに評価した遷移後の状態
+        for (const int move : moves)
+        {
+            double next_score;
+            std::shared_ptr<NonContextualState> next_state = nullptr;
+            if (use_delta_score)
+            {
+                next_score = now_state->evaluated_score_ + now_state->delta_score(move);
+            }
+            else
+            {
+                next_state = now_state->clone();
+                next_state->transition(move);
+                next_score = next_state->evaluate_score();
+            }
+            if (found && next_score <= chosen_score)
+                continue;
+            const uint64_t attribute = now_state->move_attribute(move);
+            const int64_t *until = tabu_until.find(attribute);
+            if (until != nullptr && *until > i && next_score <= best_state->evaluated_score_)
+                continue;
+            found = true;
+            chosen_move = move;
+            chosen_attribute = attribute;
+            chosen_score = next_score;
+            chosen_state = next_state;
+        }
+        // 全ての遷移が禁止されていれば、禁止が解けるまで待つ
+        if (!found)
+            continue;
+
+        tabu_until[chosen_attribute] = i + 1 + tenure;
+        if (chosen_state != nullptr)
+        {
+            now_state = chosen_state;
+        }
+        else
+        {
+            now_state->transition(chosen_move);
+        }
+        now_state->evaluated_score_ = chosen_score;
+        if (now_state->evaluated_score_ > best_state->evaluated_score_)
+        {
+            best_state = now_state->clone();
+            best_state->evaluated_score_ = now_state->evaluated_score_;
+        }
+    }
+    // 変化量の積み重ねによる誤差を残さないように評価し直す
+    best_state->evaluated_score_ = best_state->evaluate_score();
+    return best_state;
+}
+
+// 焼きなまし法の温度スケジュール
+enum class TemperatureSchedule
+{
+    Linear,      // 開始温度から終了温度へ線形に下げる
+    Exponential, // 開始温度から終了温度へ指数的に下げる
+};
+
+// 経過割合[0, 1]から温度を求める関数をつくる
+inline std::function<double(double)> makeTemperatureSchedule(const TemperatureSchedule schedule, const double start_temp, const double end_temp)
+{
+    if (schedule == TemperatureSchedule::Exponential)
+    {
+        if (start_temp <= 0 || end_temp <= 0)
+            throw std::invalid_argument("temperatures must be positive for the exponential schedule");
+        return [start_temp, end_temp](const double rate)
+        { return start_temp * std::pow(end_temp / start_temp, rate); };
+    }
+    return [start_temp, end_temp](const double rate)
+    { return start_temp + (end_temp - start_temp) * rate; };
+}
+
+// 焼きなまし法の遷移を受理するか判定する
+// 悪化する遷移はexp(delta / temperature) > uで受理するが、
+// 両辺の対数をとりdelta > temperature * log(u)とし、log(u)は事前計算した表から引く
+class AnnealingAcceptor
+{
+private:
+    static constexpr int LOG_TABLE_BITS = 16;
+    std::vector<double> log_table_;
+
+public:
+    AnnealingAcceptor() : log_table_(1 << LOG_TABLE_BITS)
+    {
+        for (int i = 0; i < static_cast<int>(log_table_.size()); i++)
+            log_table_[i] = std::log((i + 0.5) / log_table_.size());
+    }
+
+    bool accept(const double delta, const double temperature, RandomGenerator &rng) const
+    {
+        if (delta >= 0)
+            return true;
+        if (temperature <= 0)
+            return false;
+        return delta > temperature * log_table_[rng.next() >> (32 - LOG_TABLE_BITS)];
+    }
+};
+
+// 近傍を1つ選び、温度temperatureで受理するなら遷移させる。遷移したかを返す
+// delta_scoreがなければ複製した状態で評価し、受理したときだけnow_stateを置き換える
+inline bool annealingStep(std::shared_ptr<NonContextualState> &now_state, const double temperature, const bool use_delta_score, RandomGenerator &rng)
+{
+    static const AnnealingAcceptor acceptor;
+    const int move = now_state->neighbor(rng);
+    if (use_delta_score)
+    {
+        const double delta = now_state->delta_score(move);
+        if (!acceptor.accept(delta, temperature, rng))
+            return false;
+        now_state->transition(move);
+        now_state->evaluated_score_ += delta;
+        return true;
+    }
+    auto next_state = now_state->clone();
+    next_state->transition(move);
+    next_state->evaluated_score_ = next_state->evaluate_score();
+    if (!acceptor.accept(next_state->evaluated_score_ - now_state->evaluated_score_, temperature, rng))
+        return false;
+    now_state = next_state;
+    return true;
+}
+
+// 焼きなまし法で状態を改善し、探索中に見つけた最良の状態を返す
+// 温度と時間はcheck_interval回の反復ごとにだけ更新する
+inline std::shared_ptr<NonContextualState> simulatedAnnealing(
+    std::shared_ptr<NonContextualState> state,
+    const std::function<double(double)> &temperature_schedule,
+    const int64_t time_limit,
+    const int64_t iterations = 0,
+    const int check_interval = 100,
+    const uint64_t seed = 0)
+{
+    checkSearchLimit(iterations, time_limit);
+    if (check_interval <= 0)
+        throw std::invalid_argument("check_interval must be positive");
+    RandomGenerator rng(seed);
+    TimeKeeper time_keeper(time_limit);
+
+    auto now_state = state->clone();
+    now_state->evaluated_score_ = now_state->evaluate_score();
+    auto best_state = now_state->clone();
+    best_state->evaluated_score_ = now_state->evaluated_score_;
+    const bool use_delta_score = now_state->has_delta_score();
+    double temperature = temperature_schedule(0);
+
+    for (int64_t i = 0; iterations <= 0 || i < iterations; i++)
+    {
+        if (i % check_interval == 0)
+        {
+            if (time_keeper.isTimeOver())
+                break;
+            const double rate = iterations > 0
+                                    ? std::max(time_keeper.elapsedRate(), static_cast<double>(i) / iterations)
+                                    : time_keeper.elapsedRate();
+            temperature = temperature_schedule(rate);
+        }
+        if (!annealingStep(now_state, temperature, use_delta_score, rng))
+            continue;
+        if (now_state->evaluated_score_ > best_state->evaluated_score_)
+        {
+            best_state = now_state->clone();
+            best_state->evaluated_score_ = now_state->evaluated_score_;
+        }
+    }
+    best_state->evaluated_score_ = best_state->evaluate_score();
+    return best_state;
+}
+
+// 固定数のスレッドで添字ごとの処理を並列に実行するスレッドプール
+// Pythonの状態を扱う場合は、呼び出し側でGILを解放してから使う
+class ThreadPool
+{
+private:
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable start_condition_;
+    std::condition_variable done_condition_;
+    const std::function<void(int)> *task_ = nullptr;
+    int task_number_ = 0;
+    std::atomic<int> next_index_{0};
+    int running_workers_ = 0;
+    uint64_t generation_ = 0;
+    bool stop_ = false;
+    std::exception_ptr error_ = nullptr;
+
+    // 未処理の添字がなくなるまで処理を取り出して実行する
+    void runTasks()
+    {
+        for (int i = next_index_.fetch_add(1); i < task_number_; i = next_index_.fetch_add(1))
+        {
+            try
+            {
+                (*task_)(i);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (error_ == nullptr)
+                    error_ = std::current_exception();
+            }
+        }
+    }
+
+    void workerLoop()
+    {
+        uint64_t seen_generation = 0;
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                start_condition_.wait(lock, [&]
+                                      { return stop_ || generation_ != seen_generation; });
+                if (stop_)
+                    return;
+                seen_generation = generation_;
+            }
+            runTasks();
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (--running_workers_ == 0)
+                done_condition_.notify_one();
+        }
+    }
+
+public:
+    // thread_numberが1以下なら呼び出し元のスレッドだけで実行する
+    explicit ThreadPool(const int thread_number)
+    {
+        for (int i = 1; i < thread_number; i++)
+            workers_.emplace_back([this]
+                                  { workerLoop(); });
+    }
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        start_condition_.notify_all();
+        for (auto &worker : workers_)
+            worker.join();
+    }
+
+    // 呼び出し元を含めたスレッド数
+    int size() const { return static_cast<int>(workers_.size()) + 1; }
+
+    // task(0)からtask(task_number - 1)を実行し、全て終わるまで待つ
+    // いずれかが例外を投げた場合は、最初の例外を呼び出し元で投げ直す
+    void parallelFor(const int task_number, const std::function<void(int)> &task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            task_ = &task;
+            task_number_ = task_number;
+            next_index_ = 0;
+            error_ = nullptr;
+            running_workers_ = static_cast<int>(workers_.size());
+            generation_++;
+        }
+        start_condition_.notify_all();
+        runTasks();
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_condition_.wait(lock, [&]
+                             { return running_workers_ == 0; });
+        if (error_ != nullptr)
+            std::rethrow_exception(error_);
+    }
+};
+
+// まとめて実行したプレイアウトの結果
+struct RolloutBatch
+{
+    std::vector<double> scores;    // 各プレイアウトの終わりの状態の評価値。合法でない状態で終わったら-inf
+    std::vector<int> lengths;      // 各プレイアウトの手数
+    std::vector<int> best_actions; // 評価値が最も高いプレイアウトの行動列。keep_bestのときだけ記録する
+};
+
+// stateからn回のランダムプレイアウトをthreads個のスレッドで実行する
+// i回目のプレイアウトはseedとiで決まる乱数列を使うので、結果はスレッド数によらない
+// 評価値が同じプレイアウトが複数あれば、添字が最も小さいものの行動列を残す
+inline RolloutBatch randomRollouts(std::shared_ptr<ContextualState> state, const int n, const int threads, const uint64_t seed, const bool keep_best,
+                                   const std::vector<double> &action_weights)
+{
+    if (n < 0)
+        throw std::invalid_argument("n must not be negative");
+    RolloutBatch batch;
+    batch.scores.resize(n);
+    batch.lengths.resize(n);
+    std::mutex best_mutex;
+    int best_index = -1;
+    const RolloutPolicy policy(action_weights);
+
+    ThreadPool pool(threads);
+    pool.parallelFor(n, [&](const int i)
+                     {
+                         RandomGenerator rng(seed, static_cast<uint64_t>(i));
+                         // スレッドごとに使い回す行動列のバッファ
+                         thread_local std::vector<int> actions;
+                         actions.clear();
+                         int length = 0;
+                         auto end_state = randomRollout(
+                             state,
+                             policy.picker(rng),
+                             [&](ContextualState &, const int action)
+                             {
+                                 length++;
+                                 if (keep_best)
+                                     actions.emplace_back(action);
+                             });
+                         const double score = rolloutScore(*end_state);
+                         batch.scores[i] = score;
+                         batch.lengths[i] = length;
+                         if (!keep_best)
+                             return;
+                         std::lock_guard<std::mutex> lock(best_mutex);
+                         if (best_index < 0 || score > batch.scores[best_index] || (score == batch.scores[best_index] && i < best_index))
+                         {
+                             best_index = i;
+                             batch.best_actions.assign(actions.begin(), actions.end());
+                         } });
+    return batch;
+}
+
+// 全スレッドがそろうまで待つバリア。待つ間は眠らずにyieldするので、短い間隔で何度も同期できる
+// いずれかのスレッドが例外で抜けるときはabortを呼び、待っている他のスレッドも抜けさせる
+class SpinBarrier
+{
+private:
+    const int count_;
+    std::atomic<int> waiting_{0};
+    std::atomic<uint64_t> generation_{0};
+    std::atomic<bool> aborted_{false};
+
+public:
+    explicit SpinBarrier(const int count) : count_(count) {}
+
+    // 最後に着いたスレッドだけがon_completeを呼び、その後で全員を進める
+    // 中断されていればfalseを返す
+    template <class OnComplete>
+    bool arriveAndWait(OnComplete &&on_complete)
+    {
+        if (aborted_.load())
+            return false;
+        const uint64_t generation = generation_.load(std::memory_order_acquire);
+        if (waiting_.fetch_add(1, std::memory_order_acq_rel) + 1 == count_)
+        {
+            try
+            {
+                on_complete();
+            }
+            catch (...)
+            {
+                abort();
+                throw;
+            }
+            waiting_.store(0, std::memory_order_relaxed);
+            generation_.fetch_add(1, std::memory_order_release);
+            return true;
+        }
+        while (generation_.load(std::memory_order_acquire) == generation)
+        {
+            if (aborted_.load())
+                return false;
+            std::this_thread::yield();
+        }
+        return true;
+    }
+
+    void abort() { aborted_.store(true); }
+};
+
+// レプリカ交換法(パラレルテンパリング)で状態を改善し、全レプリカで見つけた最良の状態を返す
+// スレッドごとに1つのレプリカを持ち、温度はstart_tempからend_tempまで等比に割り当てる
+// 各レプリカがswap_interval回遷移するごとにバリアで同期し、隣り合う温度のレプリカの状態を
+// 確率min(1, exp((s_hot - s_cold) * (1 / T_cold - 1 / T_hot)))で交換する
+// iterationsはレプリカ1つあたりの反復回数
+inline std::shared_ptr<NonContextualState> parallelTempering(
+    std::shared_ptr<NonContextualState> state,
+    const double start_temp,
+    const double end_temp,
+    const int64_t time_limit,
+    const int64_t iterations,
+    const int threads,
+    const int swap_interval,
+    const uint64_t seed)
+{
+    checkSearchLimit(iterations, time_limit);
+    if (start_temp <= 0 || end_temp <= 0)
+        throw std::invalid_argument("temperatures must be positive");
+    if (swap_interval <= 0)
+        throw std::invalid_argument("swap_interval must be positive");
+    const int replica_number = std::max(threads, 1);
+    TimeKeeper time_keeper(time_limit);
+    // 交換の判定とレプリカごとに、重ならない乱数列を使う
+    RandomGenerator swap_rng(seed);
+    std::vector<RandomGenerator> replica_rngs;
+    for (int i = 0; i < replica_number; i++)
+        replica_rngs.push_back(swap_rng.split());
+
+    // 添字0が最も温度が低い
+    std::vector<double> temperatures(replica_number);
+    std::vector<std::shared_ptr<NonContextualState>> now_states(replica_number);
+    std::vector<std::shared_ptr<NonContextualState>> best_states(replica_number);
+    for (int i = 0; i < replica_number; i++)
+    {
+        temperatures[i] = replica_number == 1 ? end_temp : end_temp * std::pow(start_temp / end_temp, static_cast<double>(i) / (replica_number - 1));
+        now_states[i] = state->clone();
+        now_states[i]->evaluated_score_ = now_states[i]->evaluate_score();
+        best_states[i] = now_states[i]->clone();
+        best_states[i]->evaluated_score_ = now_states[i]->evaluated_score_;
+    }
+    const bool use_delta_score = now_states[0]->has_delta_score();
+
+    SpinBarrier barrier(replica_number);
+    int64_t done_iterations = 0;
+    int swap_parity = 0;
+    bool finished = false;
+    // 全レプリカがそろったときに最後のスレッドだけが呼ぶ
+    const auto exchange = [&]()
+    {
+        done_iterations += swap_interval;
+        finished = time_keeper.isTimeOver() || (iterations > 0 && done_iterations >= iterations);
+        for (int i = swap_parity; i + 1 < replica_number; i += 2)
+        {
+            const double cold_score = now_states[i]->evaluated_score_;
+            const double hot_score = now_states[i + 1]->evaluated_score_;
+            const double log_ratio = (hot_score - cold_score) * (1. / temperatures[i] - 1. / temperatures[i + 1]);
+            if (log_ratio >= 0 || swap_rng.random() < std::exp(log_ratio))
+                std::swap(now_states[i], now_states[i + 1]);
+        }
+        swap_parity ^= 1;
+    };
+
+    ThreadPool pool(replica_number);
+    pool.parallelFor(replica_number, [&](const int replica)
+                     {
+                         RandomGenerator &rng = replica_rngs[replica];
+                         try
+                         {
+                             while (true)
+                             {
+                                 auto &now_state = now_states[replica];
+                                 auto &best_state = best_states[replica];
+                                 for (int i = 0; i < swap_interval; i++)
+                                 {
+                                     if (!annealingStep(now_state, temperatures[replica], use_delta_score, rng))
+                                         continue;
+                                     if (now_state->evaluated_score_ > best_state->evaluated_score_)
+                                     {
+                                         best_state = now_state->clone();
+                                         best_state->evaluated_score_ = now_state->evaluated_score_;
+                                     }
+                                 }
+                                 if (!barrier.arriveAndWait(exchange) || finished)
+                                     return;
+                             }
+                         }
+                         catch (...)
+                         {
+                             barrier.abort();
+                             throw;
+                         } });
+
+    auto best_state = *std::max_element(best_states.begin(), best_states.end(),
+                                        [](const std::shared_ptr<NonContextualState> &a, const std::shared_ptr<NonContextualState> &b)
+                                        { return a->evaluated_score_ < b->evaluated_score_; });
+    best_state->evaluated_score_ = best_state->evaluate_score();
+    return best_state;
+}
+
+class GeneticState : public std::enable_shared_from_this<GeneticState>
+{
+public:
+    double evaluated_score_ = 0; // 探索上で評価したスコア
+    bool evaluated_ = false;     // evaluated_score_が計算済みか
+
+    virtual ~GeneticState() {}
+    virtual std::shared_ptr<GeneticState> clone() const = 0;
+
+    // 自身とotherを親として子を1つつくる。親は変更しない
+    virtual std::shared_ptr<GeneticState> crossover(const std::shared_ptr<GeneticState> &other, RandomGenerator &rng) = 0;
+
+    // 自身を突然変異させる
+    virtual void mutate(RandomGenerator &rng) = 0;
+
+    // 探索用の盤面評価をする
+    virtual double evaluate_score() = 0;
+};
+
+// 遺伝的アルゴリズムの設定
+struct GeneticConfig
+{
+    int64_t generations = 0;     // 世代数。0以下なら世代数で打ち切らない
+    int64_t time_limit = 0;      // 制限時間(ミリ秒)。0以下なら時間で打ち切らない
+    int islands = 1;             // 独立に進化させる部分集団の数
+    int migration_interval = 10; // 何世代ごとに島の間で移住させるか
+    int migration_size = 1;      // 1回の移住で隣の島へ送る個体数
+    int elite_size = 1;          // 選択を経ずに次世代へ残す上位個体数
+    int tournament_size = 3;     // トーナメント選択で比べる個体数
+    double mutation_rate = 0.2;  // 子が突然変異する確率
+    int threads = 1;             // 評価と交叉に使うスレッド数
+    uint64_t seed = 0;           // 乱数のシード。島ごとに重ならない乱数列を使うので、結果はスレッド数によらない
+};
+
+// 遺伝的アルゴリズムで個体集団を進化させ、最良の個体を返す
+// 島モデルで部分集団ごとに世代交代し、一定世代ごとに環状に隣の島へ上位個体を移住させる
+// 個体の評価と各島の交叉はスレッドプールで並列に実行する
+inline std::shared_ptr<GeneticState> geneticAlgorithm(const std::vector<std::shared_ptr<GeneticState>> &population, const GeneticConfig &config)
+{
+    using Individual = std::shared_ptr<GeneticState>;
+    using Island = std::vector<Individual>;
+    checkSearchLimit(config.generations, config.time_limit);
+    if (config.islands <= 0 || static_cast<int>(population.size()) < config.islands * 2)
+        throw std::invalid_argument("population must have at least two individuals per island");
+    if (config.tournament_size <= 0)
+        throw std::invalid_argument("tournament_size must be positive");
+
+    TimeKeeper time_keeper(config.time_limit);
+    ThreadPool pool(config.threads);
+    RandomGenerator seed_rng(config.seed);
+    std::vector<RandomGenerator> island_rngs;
+    std::vector<Island> islands(config.islands);
+    for (int i = 0; i < config.islands; i++)
+        island_rngs.push_back(seed_rng.split());
+    for (int i = 0; i < static_cast<int>(population.size()); i++)
+        islands[i % config.islands].emplace_back(population[i]->clone());
+
+    const auto by_score = [](const Individual &a, const Individual &b)
+    { return a->evaluated_score_ > b->evaluated_score_; };
+
+    // 未評価の個体をまとめて並列に評価する
+    const auto evaluate = [&](const std::vector<Island> &targets)
+    {
+        std::vector<GeneticState *> pending;
+        for (const auto &island : targets)
+            for (const auto &individual : island)
+                if (!individual->evaluated_)
+                    pending.emplace_back(individual.get());
+        pool.parallelFor(static_cast<int>(pending.size()), [&](const int i)
+                         {
+                             pending[i]->evaluated_score_ = pending[i]->evaluate_score();
+                             pending[i]->evaluated_ = true; });
+    };
+    evaluate(islands);
+    for (auto &island : islands)
+        std::sort(island.begin(), island.end(), by_score);
+
+    std::vector<Island> offsprings(config.islands);
+    for (int64_t generation = 1; config.generations <= 0 || generation <= config.generations; generation++)
+    {
+        if (time_keeper.isTimeOver())
+            break;
+        // 島ごとにトーナメント選択した親から子をつくる
+        pool.parallelFor(config.islands, [&](const int island_id)
+                         {
+                             const auto &island = islands[island_id];
+                             auto &rng = island_rngs[island_id];
+                             const int size = static_cast<int>(island.size());
+                             const int elite_size = std::min(std::max(config.elite_size, 0), size);
+                             const auto select = [&]()
+                             {
+                                 int best = rng.randrange(size);
+                                 for (int k = 1; k < config.tournament_size; k++)
+                                     best = std::min(best, rng.randrange(size));
+                                 return island[best];
+                             };
+                             auto &children = offsprings[island_id];
+                             children.clear();
+                             for (int k = elite_size; k < size; k++)
+                             {
+                                 auto child = select()->crossover(select(), rng);
+                                 if (rng.random() < config.mutation_rate)
+                                     child->mutate(rng);
+                                 child->evaluated_ = false;
+                                 children.emplace_back(child);
+                             } });
+        evaluate(offsprings);
+        // 上位個体を残し、残りを子で置き換える
+        for (int island_id = 0; island_id < config.islands; island_id++)
+        {
+            auto &island = islands[island_id];
+            auto &children = offsprings[island_id];
+            island.resize(island.size() - children.size());
+            island.insert(island.end(), children.begin(), children.end());
+            std::sort(island.begin(), island.end(), by_score);
+        }
+        // 各島の上位個体の複製で、隣の島の下位個体を置き換える
+        if (config.islands > 1 && config.migration_interval > 0 && generation % config.migration_interval == 0)
+        {
+            std::vector<Island> migrants(config.islands);
+            for (int island_id = 0; island_id < config.islands; island_id++)
+            {
+                const auto &island = islands[island_id];
+                const int migration_size = std::min(config.migration_size, static_cast<int>(island.size()) - 1);
+                for (int k = 0; k < migration_size; k++)
+                {
+                    auto migrant = island[k]->clone();
+                    migrant->evaluated_score_ = island[k]->evaluated_score_;
+                    migrant->evaluated_ = true;
+                    migrants[(island_id + 1) % config.islands].emplace_back(migrant);
+                }
+            }
+            for (int island_id = 0; island_id < config.islands; island_id++)
+            {
+                auto &island = islands[island_id];
+                std::copy(migrants[island_id].begin(), migrants[island_id].end(), island.end() - migrants[island_id].size());
+                std::sort(island.begin(), island.end(), by_score);
+            }
+        }
+    }
+
+    Individual best = nullptr;
+    for (const auto &island : islands)
+        if (best == nullptr || island.front()->evaluated_score_ > best->evaluated_score_)
+            best = island.front();
+    return best;
+}
+
+class AlternateState : public std::enable_shared_from_this<AlternateState>
+{
+public:
+    virtual ~AlternateState() {}
+    virtual std::shared_ptr<AlternateState> clone() const = 0;
+    virtual void advance(const int action) = 0;
+    virtual std::vector<int> _legal_actions() = 0;
+
+    // 呼び出し側が使い回すバッファに合法手を書き込む
+    virtual void legal_actions_into(ActionBuffer &buffer)
+    {
+        auto actions = _legal_actions();
+        buffer.assign(actions.begin(), actions.end());
+    }
+
+    // ゲームの終了判定
+    virtual bool is_done() = 0;
+
+    // 手番のプレイヤーから見た盤面評価をする。大きいほど手番のプレイヤーが有利
+    virtual double evaluate_score() = 0;
+
+    // 置換表などで盤面を見分けるためのハッシュ値
+    virtual uint64_t hash() = 0;
+
+    std::shared_ptr<AlternateState> cloneAdvanced(int action)
+    {
+        auto clone = this->clone();
+        clone->advance(action);
+        return clone;
+    }
+};
+
+// 置換表に記録した評価値が、真の値に対してどういう値か
+enum class BoundType : uint8_t
+{
+    Exact, // 真の値そのもの
+    Lower, // 真の値の下限(betaカットした)
+    Upper, // 真の値の上限(alphaを超えなかった)
+};
+
+// 置換表の1エントリ
+struct TranspositionEntry
+{
+    uint64_t key = 0;
+    double score = 0;
+    int depth = -1; // 探索した残り深さ。-1なら空
+    int best_action = -1;
+    BoundType bound = BoundType::Exact;
+};
+
+// 盤面のハッシュ値をキーにした固定長の置換表
+// 同じ位置に書き込む場合は、別の盤面か残り深さが同じ以上のときに上書きする
+class TranspositionTable
+{
+private:
+    std::vector<TranspositionEntry> entries_;
+    uint64_t mask_;
+
+public:
+    // capacityを超えない最大の2の冪をエントリ数にする
+    explicit TranspositionTable(const std::size_t capacity)
+    {
+        std::size_t size = 1;
+        while (size * 2 <= std::max<std::size_t>(capacity, 1))
+            size *= 2;
+        entries_.resize(size);
+        mask_ = size - 1;
+    }
+
+    std::size_t size() const { return entries_.size(); }
+
+    const TranspositionEntry *probe(const uint64_t key) const
+    {
+        const auto &entry = entries_[key & mask_];
+        if (entry.depth < 0 || entry.key != key)
+            return nullptr;
+        return &entry;
+    }
+
+    void store(const uint64_t key, const int depth, const double score, const BoundType bound, const int best_action)
+    {
+        auto &entry = entries_[key & mask_];
+        if (entry.depth >= 0 && entry.key == key && entry.depth > depth)
+            return;
+        entry.key = key;
+        entry.depth = depth;
+        entry.score = score;
+        entry.bound = bound;
+        entry.best_action = best_action;
+    }
+
+    void clear() { std::fill(entries_.begin(), entries_.end(), TranspositionEntry()); }
+};
+
+// 時間切れで反復深化の途中の探索を打ち切るための例外
+struct SearchTimeOver
+{
+};
+
+// 置換表つきのネガマックス形式のアルファベータ法
+class AlphaBetaSearcher
+{
+private:
+    TranspositionTable &table_;
+    const TimeKeeper &time_keeper_;
+
+public:
+    AlphaBetaSearcher(TranspositionTable &table, const TimeKeeper &time_keeper)
+        : table_(table), time_keeper_(time_keeper) {}
+
+    // 手番のプレイヤーから見た評価値を返す。first_actionは最初に調べる手
+    double search(const std::shared_ptr<AlternateState> &state, double alpha, const double beta, const int depth, int *best_action = nullptr, const int first_action = -1)
+    {
+        if (time_keeper_.isTimeOver())
+            throw SearchTimeOver();
+        if (state->is_done() || depth == 0)
+            return state->evaluate_score();
+
+        const uint64_t key = state->hash();
+        int ordered_action = first_action;
+        const auto *entry = table_.probe(key);
+        if (entry != nullptr)
+        {
+            if (entry->depth >= depth && best_action == nullptr)
+            {
+                if (entry->bound == BoundType::Exact)
+                    return entry->score;
+                if (entry->bound == BoundType::Lower && entry->score >= beta)
+                    return entry->score;
+                if (entry->bound == BoundType::Upper && entry->score <= alpha)
+                    return entry->score;
+            }
+            if (ordered_action < 0)
+                ordered_action = entry->best_action;
+        }
+
+        ActionBuffer legal_actions;
+        state->legal_actions_into(legal_actions);
+        if (legal_actions.empty())
+            return state->evaluate_score();
+        // 前回の反復の最善手を先に調べると枝刈りが起きやすい
+        for (std::size_t i = 1; i < legal_actions.size(); i++)
+        {
+            if (legal_actions[i] == ordered_action)
+            {
+                std::swap(legal_actions[0], legal_actions[i]);
+                break;
+            }
+        }
+
+        const double original_alpha = alpha;
+        double best_score = -std::numeric_limits<double>::infinity();
+        int best = legal_actions[0];
+        for (const auto &action : legal_actions)
+        {
+            const double score = -search(state->cloneAdvanced(action), -beta, -alpha, depth - 1);
+            if (score > best_score)
+            {
+                best_score = score;
+                best = action;
+            }
+            alpha = std::max(alpha, score);
+            if (alpha >= beta)
+                break;
+        }
+
+        const BoundType bound = best_score <= original_alpha ? BoundType::Upper
+                                : best_score >= beta         ? BoundType::Lower
+                                                             : BoundType::Exact;
+        table_.store(key, depth, best_score, bound, best);
+        if (best_action != nullptr)
+            *best_action = best;
+        return best_score;
+    }
+};
+
+// 置換表を指定してアルファベータ法で行動を決定する
+// 深さ1から反復深化し、時間切れになった反復の結果は使わない
+inline int alphaBetaActionWithTable(std::shared_ptr<AlternateState> state, const int depth, const int64_t time_limit, TranspositionTable &table)
+{
+    checkSearchLimit(depth, time_limit);
+    TimeKeeper time_keeper(time_limit);
+    AlphaBetaSearcher searcher(table, time_keeper);
+    const double inf = std::numeric_limits<double>::infinity();
+
+    int best_action = -1;
+    for (int now_depth = 1; depth <= 0 || now_depth <= depth; now_depth++)
+    {
+        int action = -1;
+        try
+        {
+            searcher.search(state, -inf, inf, now_depth, &action, best_action);
+        }
+        catch (const SearchTimeOver &)
+        {
+            break;
+        }
+        best_action = action;
+        if (action < 0)
+            break;
+    }
+    if (best_action < 0)
+    {
+        // 深さ1の探索も終わらなかった場合は最初の合法手を返す
+        ActionBuffer legal_actions;
+        state->legal_actions_into(legal_actions);
+        if (!legal_actions.empty())
+            best_action = legal_actions[0];
+    }
+    return best_action;
+}
+
+// アルファベータ法で行動を決定する
+// depthが0以下なら深さ、time_limitが0以下なら時間で打ち切らない
+inline int alphaBetaAction(std::shared_ptr<AlternateState> state, const int depth, const int64_t time_limit, const std::size_t table_size)
+{
+    TranspositionTable table(table_size);
+    return alphaBetaActionWithTable(state, depth, time_limit, table);
+}
+
+// プレイアウトを終える状態か
+inline bool isRolloutEnd(AlternateState &state) { return state.is_done(); }
+
+// 手番のプレイヤーから見た終局の価値を勝ち1、引き分け0.5、負け0で返す
+inline double terminalValue(AlternateState &state)
+{
+    const double score = state.evaluate_score();
+    return score > 0 ? 1. : score < 0 ? 0.
+                                      : 0.5;
+}
+
+// 木のノードが共通に持つ子へのリンク
+// 子ノードはNodePool上の連続した領域に確保され、先頭の添字と個数で参照する
+struct TreeNodeLinks
+{
+    int first_child = -1;
+    int child_count = 0;
+
+    bool isExpanded() const { return first_child >= 0; }
+};
+
+// 木のノードを事前に確保した連続領域に置き、添字で参照するためのプール
+// Nodeは TreeNodeLinks を継承する
+template <class Node>
+class NodePool
+{
+private:
+    std::vector<Node> nodes_;
+    std::vector<Node> spare_; // keepSubtreeで写す先。毎回確保しないように使い回す
+    int size_ = 0;
+
+    // rootの部分木を幅優先でdestへ写し、子の添字を付け替える
+    void copySubtree(const int root, std::vector<Node> &dest, int &dest_size) const
+    {
+        dest[0] = nodes_[root];
+        dest_size = 1;
+        for (int i = 0; i < dest_size; i++)
+        {
+            auto &node = dest[i];
+            if (!node.isExpanded())
+                continue;
+            const int first = dest_size;
+            for (int k = 0; k < node.child_count; k++)
+                dest[dest_size++] = nodes_[node.first_child + k];
+            node.first_child = first;
+        }
+    }
+
+public:
+    explicit NodePool(const int capacity) : nodes_(std::max(capacity, 1)) {}
+
+    int size() const { return size_; }
+    int capacity() const { return static_cast<int>(nodes_.size()); }
+    Node &operator[](const int index) { return nodes_[index]; }
+    const Node &operator[](const int index) const { return nodes_[index]; }
+
+    // count個の連続したノードを確保し、先頭の添字を返す。空きがなければ-1を返す
+    int allocate(const int count)
+    {
+        if (size_ + count > capacity())
+            return -1;
+        const int first = size_;
+        for (int i = 0; i < count; i++)
+            nodes_[first + i] = Node();
+        size_ += count;
+        return first;
+    }
+
+    void clear()
+    {
+        for (int i = 0; i < size_; i++)
+            nodes_[i] = Node();
+        size_ = 0;
+    }
+
+    // rootの部分木だけを残して先頭に詰め直す。新しい根の添字は0になる
+    void keepSubtree(const int root)
+    {
+        spare_.resize(nodes_.size());
+        int kept_size = 0;
+        copySubtree(root, spare_, kept_size);
+        nodes_.swap(spare_);
+        // 捨てたノードが状態を持ち続けないように空にしておく
+        for (int i = 0; i < size_; i++)
+            spare_[i] = Node();
+        size_ = kept_size;
+    }
+};
+
+// 交互着手ゲームの木探索のノード
+struct AlternateTreeNode : TreeNodeLinks
+{
+    std::shared_ptr<AlternateState> state = nullptr; // 初めて訪れたときに親の状態から作る
+    int action = -1;                                 // 親からこのノードへの行動
+    double w = 0;                                    // このノードで手番のプレイヤーから見た価値の累計
+    int n = 0;                                       // 訪問回数
+};
+
+// ノードを事前確保したプールに置く交互着手ゲームの木探索の共通部分
+// 探索後も木を保持し、実際に指した手をadvanceで伝えると次の探索はその部分木から始まる
+// 葉の評価と子の選び方は派生クラスで決める
+class AlternateTreeSearch
+{
+protected:
+    NodePool<AlternateTreeNode> pool_;
+    RandomGenerator rng_;
+    int expand_threshold_;
+    bool has_root_ = false;
+
+    // 展開していないノードを評価し、そのノードで手番のプレイヤーから見た価値を返す
+    virtual double evaluateLeaf(const int index) = 0;
+
+    // 展開済みのノードで次に調べる子の添字を返す
+    virtual int selectChild(const int index) const = 0;
+
+    void expand(const int index)
+    {
+        TraceScope trace("expand");
+        ActionBuffer legal_actions;
+        pool_[index].state->legal_actions_into(legal_actions);
+        if (legal_actions.empty())
+            return;
+        const int first = pool_.allocate(static_cast<int>(legal_actions.size()));
+        if (first < 0)
+            return; // プールが一杯なら葉のまま評価を続ける
+        for (int i = 0; i < static_cast<int>(legal_actions.size()); i++)
+            pool_[first + i].action = legal_actions[i];
+        pool_[index].first_child = first;
+        pool_[index].child_count = static_cast<int>(legal_actions.size());
+    }
+
+    // ノードを評価し、そのノードで手番のプレイヤーから見た価値を返す
+    // depthは根からの深さで、トレースにだけ使う
+    double evaluate(const int index, const int depth)
+    {
+        double value;
+        if (pool_[index].state->is_done())
+        {
+            value = terminalValue(*pool_[index].state);
+        }
+        else if (!pool_[index].isExpanded())
+        {
+            {
+                TraceScope trace("evaluate_leaf", depth);
+                value = evaluateLeaf(index);
+            }
+            if (pool_[index].n + 1 >= expand_threshold_)
+                expand(index);
+        }
+        else
+        {
+            int child;
+            {
+                TraceScope trace("select", depth);
+                child = selectChild(index);
+            }
+            if (pool_[child].state == nullptr)
+            {
+                TraceScope trace("clone_advance", depth + 1);
+                pool_[child].state = pool_[index].state->cloneAdvanced(pool_[child].action);
+            }
+            value = 1. - evaluate(child, depth + 1);
+        }
+        pool_[index].w += value;
+        pool_[index].n++;
+        return value;
+    }
+
+public:
+    AlternateTreeSearch(const int expand_threshold, const int node_limit, const RandomGenerator &rng)
+        : pool_(node_limit), rng_(rng), expand_threshold_(expand_threshold) {}
+    virtual ~AlternateTreeSearch() {}
+
+    // 保持している木の根の訪問回数。前の探索から引き継いだ分も含む
+    int rootVisits() const { return has_root_ ? pool_[0].n : 0; }
+
+    int nodeCount() const { return pool_.size(); }
+
+    // 根の子ごとの行動と訪問回数
+    std::vector<std::pair<int, int>> rootActionVisits() const
+    {
+        std::vector<std::pair<int, int>> visits;
+        if (!has_root_)
+            return visits;
+        const auto &root = pool_[0];
+        for (int k = 0; k < root.child_count; k++)
+            visits.emplace_back(pool_[root.first_child + k].action, pool_[root.first_child + k].n);
+        return visits;
+    }
+
+    void reset()
+    {
+        pool_.clear();
+        has_root_ = false;
+    }
+
+    // 実際に指された手を伝え、その手の部分木を次の探索のために残す
+    void advance(const int action)
+    {
+        if (!has_root_)
+            return;
+        const auto &root = pool_[0];
+        for (int k = 0; k < root.child_count; k++)
+        {
+            const auto &child = pool_[root.first_child + k];
+            if (child.action == action && child.state != nullptr)
+            {
+                pool_.keepSubtree(root.first_child + k);
+                return;
+            }
+        }
+        reset();
+    }
+
+    // stateを根にして、根を展開しておく
+    // 保持している木の根がstateと同じハッシュ値なら、その木を引き継ぐ
+    void setRoot(const std::shared_ptr<AlternateState> &state)
+    {
+        if (has_root_ && pool_[0].state->hash() != state->hash())
+            reset();
+        if (!has_root_)
+        {
+            pool_.allocate(1);
+            pool_[0].state = state->clone();
+            has_root_ = true;
+        }
+        if (!pool_[0].isExpanded())
+            expand(0);
+        const auto &root = pool_[0];
+        if (root.child_count == 0)
+        {
+            ActionBuffer legal_actions;
+            root.state->legal_actions_into(legal_actions);
+            if (legal_actions.empty())
+                throw std::invalid_argument("state has no legal actions");
+            throw std::invalid_argument("node_limit " + std::to_string(pool_.capacity()) + " is too small to expand the root: " +
+                                        std::to_string(legal_actions.size()) + " nodes are needed but only " +
+                                        std::to_string(pool_.capacity() - pool_.size()) + " are free");
+        }
+    }
+
+    // setRootで決めた根から1回分の選択・評価・逆伝播をする
+    void playout() { evaluate(0, 0); }
+
+    // 根の子のうち最も訪問回数の多い行動を返す
+    int bestAction() const
+    {
+        const auto &root = pool_[0];
+        int best_action = pool_[root.first_child].action;
+        int best_n = -1;
+        for (int k = 0; k < root.child_count; k++)
+        {
+            const auto &child = pool_[root.first_child + k];
+            if (child.n > best_n)
+            {
+                best_n = child.n;
+                best_action = child.action;
+            }
+        }
+        return best_action;
+    }
+
+    // 反復回数か制限時間(ミリ秒)の範囲で探索し、最も訪問回数の多い行動を返す
+    // 保持している木の根がstateと同じハッシュ値なら、その木を引き継いで探索する
+    int search(std::shared_ptr<AlternateState> state, const int64_t playout_number, const int64_t time_limit)
+    {
+        checkSearchLimit(playout_number, time_limit);
+        setRoot(state);
+        TimeKeeper time_keeper(time_limit);
+        for (int64_t i = 0; playout_number <= 0 || i < playout_number; i++)
+        {
+            if (time_keeper.isTimeOver())
+                break;
+            playout();
+        }
+        return bestAction();
+    }
+};
+
+// UCTによるモンテカルロ木探索
+class MctsSession : public AlternateTreeSearch
+{
+private:
+    double c_;
+
+    // 終局までランダムに進め、開始時の手番のプレイヤーから見た価値を返す
+    double evaluateLeaf(const int index) override
+    {
+        int length = 0;
+        auto end_state = randomRollout(
+            pool_[index].state,
+            [&](AlternateState &, const ActionBuffer &legal_actions)
+            { return rng_.randrange(static_cast<int>(legal_actions.size())); },
+            [&](AlternateState &, int)
+            { length++; });
+        const double value = terminalValue(*end_state);
+        return length % 2 == 0 ? value : 1 - value;
+    }
+
+    int selectChild(const int index) const override
+    {
+        const auto &node = pool_[index];
+        const double log_n = std::log(static_cast<double>(node.n));
+        int best = -1;
+        double best_ucb = -std::numeric_limits<double>::infinity();
+        for (int k = 0; k < node.child_count; k++)
+        {
+            const auto &child = pool_[node.first_child + k];
+            if (child.n == 0)
+                return node.first_child + k;
+            const double ucb = 1. - child.w / child.n + c_ * std::sqrt(2. * log_n / child.n);
+            if (ucb > best_ucb)
+            {
+                best_ucb = ucb;
+                best = node.first_child + k;
+            }
+        }
+        return best;
+    }
+
+public:
+    MctsSession(const double c, const int expand_threshold, const int node_limit, const RandomGenerator &rng)
+        : AlternateTreeSearch(expand_threshold, node_limit, rng), c_(c) {}
+};
+
+// プレイアウトをせず、葉の盤面評価だけで木を育てるThunderサーチ
+// evaluate_scoreをロジスティック関数で[0, 1]の価値に直し、未訪問の子を優先したうえで価値が最大の子を選ぶ
+class ThunderSession : public AlternateTreeSearch
+{
+private:
+    double score_scale_;
+
+    double evaluateLeaf(const int index) override
+    {
+        return 1. / (1. + std::exp(-pool_[index].state->evaluate_score() / score_scale_));
+    }
+
+    int selectChild(const int index) const override
+    {
+        const auto &node = pool_[index];
+        int best = -1;
+        double best_value = -std::numeric_limits<double>::infinity();
+        for (int k = 0; k < node.child_count; k++)
+        {
+            const auto &child = pool_[node.first_child + k];
+            if (child.n == 0)
+                return node.first_child + k;
+            const double value = 1. - child.w / child.n;
+            if (value > best_value)
+            {
+                best_value = value;
+                best = node.first_child + k;
+            }
+        }
+        return best;
+    }
+
+public:
+    ThunderSession(const double score_scale, const int expand_threshold, const int node_limit, const RandomGenerator &rng)
+        : AlternateTreeSearch(expand_threshold, node_limit, rng), score_scale_(score_scale)
+    {
+        if (score_scale <= 0)
+            throw std::invalid_argument("score_scale must be positive");
+    }
+};
+
+// プレイアウト回数か制限時間(ミリ秒)を指定してモンテカルロ木探索で行動を決定する
+inline int mctsAction(std::shared_ptr<AlternateState> state, const int64_t playout_number, const int64_t time_limit,
+                      const double c, const int expand_threshold, const int node_limit, const uint64_t seed)
+{
+    MctsSession session(c, expand_threshold, node_limit, RandomGenerator(seed));
+    return session.search(state, playout_number, time_limit);
+}
+
+// 反復回数か制限時間(ミリ秒)を指定してThunderサーチで行動を決定する
+inline int thunderSearchAction(std::shared_ptr<AlternateState> state, const int64_t playout_number, const int64_t time_limit,
+                               const double score_scale, const int expand_threshold, const int node_limit, const uint64_t seed)
+{
+    ThunderSession session(score_scale, expand_threshold, node_limit, RandomGenerator(seed));
+    return session.search(state, playout_number, time_limit);
+}
+
+// 並列モンテカルロ木探索の並列化の方法
+enum class ParallelMode
+{
+    Tree, // 全スレッドで1つの木を共有して育てる
+    Root, // スレッドごとに独立した木を育て、最後に根の訪問回数を合算する
+};
+
+// 複数スレッドで共有する木のノード
+// 訪問回数と価値はatomicに更新し、価値は固定小数点で持つ
+struct SharedTreeNode
+{
+    static constexpr int64_t VALUE_SCALE = 1 << 16;
+    enum Status
+    {
+        EMPTY = 0,
+        BUSY = 1,
+        READY = 2,
+    };
+
+    std::shared_ptr<AlternateState> state = nullptr; // state_statusがREADYになってから読む
+    std::atomic<int> state_status{EMPTY};
+    std::atomic<int> expand_status{EMPTY};
+    int first_child = -1; // expand_statusがREADYになってから読む
+    int child_count = 0;
+    int action = -1;
+    std::atomic<int> n{0};
+    std::atomic<int64_t> w{0}; // このノードで手番のプレイヤーから見た価値の累計 * VALUE_SCALE
+    std::atomic<int> virtual_loss{0};
+};
+
+// 1つの木を複数スレッドで育てるモンテカルロ木探索
+// 降りる途中のノードに仮想的な負けを足して、他のスレッドが別の枝を調べるようにする
+// 子の展開とノードの確保はロックを使わずcompare-and-swapで行う
+class TreeParallelMcts
+{
+private:
+    std::vector<SharedTreeNode> nodes_;
+    std::atomic<int> size_{0};
+    double c_;
+    int virtual_loss_;
+    int expand_threshold_;
+
+    // count個の連続したノードを確保し、先頭の添字を返す。空きがなければ-1を返す
+    int allocate(const int count)
+    {
+        int size = size_.load();
+        do
+        {
+            if (size + count > static_cast<int>(nodes_.size()))
+                return -1;
+        } while (!size_.compare_exchange_weak(size, size + count));
+        return size;
+    }
+
+    // 最初に展開権を得たスレッドだけが子を確保する。他のスレッドはその間も葉として扱う
+    void tryExpand(SharedTreeNode &node)
+    {
+        int expected = SharedTreeNode::EMPTY;
+        if (!node.expand_status.compare_exchange_strong(expected, SharedTreeNode::BUSY))
+            return;
+        ActionBuffer legal_actions;
+        node.state->legal_actions_into(legal_actions);
+        const int count = static_cast<int>(legal_actions.size());
+        const int first = count > 0 ? allocate(count) : -1;
+        if (first < 0)
+        {
+            node.expand_status.store(SharedTreeNode::EMPTY);
+            return;
+        }
+        for (int i = 0; i < count; i++)
+            nodes_[first + i].action = legal_actions[i];
+        node.first_child = first;
+        node.child_count = count;
+        node.expand_status.store(SharedTreeNode::READY, std::memory_order_release);
+    }
+
+    // 子の状態がなければ親から作る。他のスレッドが作っている途中なら出来上がりを待つ
+    void prepareState(SharedTreeNode &parent, SharedTreeNode &child)
+    {
+        int expected = SharedTreeNode::EMPTY;
+        if (child.state_status.compare_exchange_strong(expected, SharedTreeNode::BUSY))
+        {
+            child.state = parent.state->cloneAdvanced(child.action);
+            child.state_status.store(SharedTreeNode::READY, std::memory_order_release);
+            return;
+        }
+        while (child.state_status.load(std::memory_order_acquire) != SharedTreeNode::READY)
+            std::this_thread::yield();
+    }
+
+    int selectChild(const SharedTreeNode &node) const
+    {
+        const double log_n = std::log(static_cast<double>(node.n.load() + node.virtual_loss.load() + 1));
+        int best = node.first_child;
+        double best_ucb = -std::numeric_limits<double>::infinity();
+        for (int k = 0; k < node.child_count; k++)
+        {
+            const auto &child = nodes_[node.first_child + k];
+            const int loss = child.virtual_loss.load(std::memory_order_relaxed);
+            const int n = child.n.load(std::memory_order_relaxed) + loss;
+            if (n == 0)
+                return node.first_child + k;
+            // 仮想的な負けは、子の手番のプレイヤーの勝ちとして数える
+            const double w = static_cast<double>(child.w.load(std::memory_order_relaxed)) / SharedTreeNode::VALUE_SCALE + loss;
+            const double ucb = 1. - w / n + c_ * std::sqrt(2. * log_n / n);
+            if (ucb > best_ucb)
+            {
+                best_ucb = ucb;
+                best = node.first_child + k;
+            }
+        }
+        return best;
+    }
+
+public:
+    TreeParallelMcts(const double c, const int virtual_loss, const int expand_threshold, const int node_limit)
+        : nodes_(std::max(node_limit, 1)), c_(c), virtual_loss_(virtual_loss), expand_threshold_(expand_threshold) {}
+
+    void setRoot(const std::shared_ptr<AlternateState> &state)
+    {
+        allocate(1);
+        nodes_[0].state = state->clone();
+        nodes_[0].state_status.store(SharedTreeNode::READY);
+        tryExpand(nodes_[0]);
+    }
+
+    // 根から葉まで降りて1回評価し、結果を逆伝播する
+    void iterate(RandomGenerator &rng)
+    {
+        SmallVector<int, 64> path;
+        path.push_back(0);
+        double value;
+        while (true)
+        {
+            auto &node = nodes_[path[path.size() - 1]];
+            if (node.state->is_done())
+            {
+                value = terminalValue(*node.state);
+                break;
+            }
+            if (node.expand_status.load(std::memory_order_acquire) != SharedTreeNode::READY)
+            {
+                {
+                    TraceScope trace("evaluate_leaf", static_cast<int>(path.size()) - 1);
+                    int length = 0;
+                    auto end_state = randomRollout(
+                        node.state,
+                        [&](AlternateState &, const ActionBuffer &legal_actions)
+                        { return rng.randrange(static_cast<int>(legal_actions.size())); },
+                        [&](AlternateState &, int)
+                        { length++; });
+                    value = terminalValue(*end_state);
+                    if (length % 2 == 1)
+                        value = 1. - value;
+                }
+                if (node.n.load(std::memory_order_relaxed) + 1 >= expand_threshold_)
+                {
+                    TraceScope trace("expand");
+                    tryExpand(node);
+                }
+                break;
+            }
+            int child_index;
+            {
+                TraceScope trace("select", static_cast<int>(path.size()) - 1);
+                child_index = selectChild(node);
+            }
+            auto &child = nodes_[child_index];
+            child.virtual_loss.fetch_add(virtual_loss_, std::memory_order_relaxed);
+            {
+                TraceScope trace("clone_advance", static_cast<int>(path.size()));
+                prepareState(node, child);
+            }
+            path.push_back(child_index);
+        }
+        for (std::size_t i = path.size(); i-- > 0;)
+        {
+            auto &node = nodes_[path[i]];
+            node.w.fetch_add(static_cast<int64_t>(value * SharedTreeNode::VALUE_SCALE), std::memory_order_relaxed);
+            node.n.fetch_add(1, std::memory_order_relaxed);
+            if (i > 0)
+                node.virtual_loss.fetch_sub(virtual_loss_, std::memory_order_relaxed);
+            value = 1. - value;
+        }
+    }
+
+    // 根の子ごとの行動と訪問回数
+    std::vector<std::pair<int, int>> rootActionVisits() const
+    {
+        std::vector<std::pair<int, int>> visits;
+        const auto &root = nodes_[0];
+        for (int k = 0; k < root.child_count; k++)
+            visits.emplace_back(nodes_[root.first_child + k].action, nodes_[root.first_child + k].n.load());
+        return visits;
+    }
+};
+
+// 行動ごとの訪問回数の合計が最も多い行動を返す
+inline int mostVisitedAction(const std::vector<std::pair<int, int>> &visits)
+{
+    std::vector<std::pair<int, int>> totals;
+    for (const auto &visit : visits)
+    {
+        auto found = std::find_if(totals.begin(), totals.end(), [&](const std::pair<int, int> &total)
+                                  { return total.first == visit.first; });
+        if (found == totals.end())
+            totals.emplace_back(visit);
+        else
+            found->second += visit.second;
+    }
+    if (totals.empty())
+        throw std::invalid_argument("state has no legal actions");
+    return std::max_element(totals.begin(), totals.end(), [](const std::pair<int, int> &a, const std::pair<int, int> &b)
+                            { return a.second < b.second; })
+        ->first;
+}
+
+// 複数スレッドでモンテカルロ木探索をして行動を決定する
+// playout_numberは全スレッドの合計で数える
+// Pythonの状態はGILで直列化されるため、速くなるのはC++で実装した状態だけ
+inline int parallelMctsAction(std::shared_ptr<AlternateState> state, const int64_t playout_number, const int64_t time_limit,
+                              const int threads, const ParallelMode mode, const double c, const int virtual_loss,
+                              const int expand_threshold, const int node_limit, const uint64_t seed)
+{
+    checkSearchLimit(playout_number, time_limit);
+    const int thread_number = std::max(threads, 1);
+    TimeKeeper time_keeper(time_limit);
+    ThreadPool pool(thread_number);
+    // スレッドごとに重ならない乱数列を使う
+    RandomGenerator seed_rng(seed);
+    std::vector<RandomGenerator> thread_rngs;
+    for (int i = 0; i < thread_number; i++)
+        thread_rngs.push_back(seed_rng.split());
+    std::atomic<int64_t> remaining_playouts{playout_number};
+    // 残りのプレイアウトを1回分確保できたか
+    const auto take_playout = [&]()
+    {
+        return !time_keeper.isTimeOver() && (playout_number <= 0 || remaining_playouts.fetch_sub(1) > 0);
+    };
+
+    if (mode == ParallelMode::Root)
+    {
+        std::vector<std::vector<std::pair<int, int>>> visits(thread_number);
+        pool.parallelFor(thread_number, [&](const int thread_id)
+                         {
+                             MctsSession session(c, expand_threshold, std::max(node_limit / thread_number, 1), thread_rngs[thread_id]);
+                             session.setRoot(state);
+                             while (take_playout())
+                                 session.playout();
+                             if (session.rootVisits() == 0)
+                                 session.playout();
+                             visits[thread_id] = session.rootActionVisits(); });
+        std::vector<std::pair<int, int>> merged;
+        for (const auto &thread_visits : visits)
+            merged.insert(merged.end(), thread_visits.begin(), thread_visits.end());
+        return mostVisitedAction(merged);
+    }
+
+    TreeParallelMcts tree(c, virtual_loss, expand_threshold, node_limit);
+    tree.setRoot(state);
+    pool.parallelFor(thread_number, [&](const int thread_id)
+                     {
+                         RandomGenerator &rng = thread_rngs[thread_id];
+                         while (take_playout())
+                             tree.iterate(rng); });
+    return mostVisitedAction(tree.rootActionVisits());
+}
+
+// 2人のプレイヤーが同時に行動を選ぶゲームの状態
+class SimultaneousState : public std::enable_shared_from_this<SimultaneousState>
+{
+public:
+    virtual ~SimultaneousState() {}
+    virtual std::shared_ptr<SimultaneousState> clone() const = 0;
+
+    // 2人の行動で状態を進める
+    virtual void advance(const int action0, const int action1) = 0;
+
+    // player_idのプレイヤーの合法手
+    virtual std::vector<int> _legal_actions(const int player_id) = 0;
+
+    // 呼び出し側が使い回すバッファにplayer_idのプレイヤーの合法手を書き込む
+    virtual void legal_actions_into(const int player_id, ActionBuffer &buffer)
+    {
+        auto actions = _legal_actions(player_id);
+        buffer.assign(actions.begin(), actions.end());
+    }
+
+    // ゲームの終了判定
+    virtual bool is_done() = 0;
+
+    // プレイヤー0から見た盤面評価をする。大きいほどプレイヤー0が有利
+    virtual double evaluate_score() = 0;
+};
+
+// プレイヤー0から見た終局の価値を勝ち1、引き分け0.5、負け0で返す
+inline double terminalValue(SimultaneousState &state)
+{
+    const double score = state.evaluate_score();
+    return score > 0 ? 1. : score < 0 ? 0.
+                                      : 0.5;
+}
+
+// DUCTのノード
+// 各プレイヤーの行動と統計量はノードの外の連続した配列に置き、先頭位置と個数で参照する
+// 子ノードは2人の行動の組ごとに action0の添字 * プレイヤー1の行動数 + action1の添字 の位置に並ぶ
+struct DuctNode : TreeNodeLinks
+{
+    std::shared_ptr<SimultaneousState> state = nullptr; // 初めて訪れたときに親の状態から作る
+    int action0 = -1;                                   // 親からこのノードへのプレイヤー0の行動
+    int action1 = -1;                                   // 親からこのノードへのプレイヤー1の行動
+    int n = 0;                                          // 訪問回数
+    int stats_offset[2] = {-1, -1};                     // プレイヤーごとの統計量の先頭位置
+    int action_count[2] = {0, 0};                       // プレイヤーごとの行動数
+};
+
+// 同時着手ゲームのためのDecoupled UCT
+// 各ノードで2人がそれぞれ自分の統計量だけを見てUCB1で行動を選ぶ
+class DuctSearcher
+{
+private:
+    NodePool<DuctNode> pool_;
+    // プレイヤーごと・ノードごとの行動と統計量。DuctNode::stats_offsetから参照する
+    // 展開1回でプールからcount0 * count1個、統計量にcount0 + count1個を取り、count0 + count1 <= count0 * count1 + 1なので
+    // 統計量の個数はプールの上限の2倍を超えない。その分を始めに確保しておき、探索中は確保し直さない
+    std::vector<int> stat_actions_;
+    std::vector<double> stat_w_; // その行動を選んだプレイヤーから見た価値の累計
+    std::vector<int> stat_n_;
+    RandomGenerator rng_;
+    double c_;
+    int expand_threshold_;
+
+    // 終局までランダムに進め、プレイヤー0から見た価値を返す
+    // 複製は最初の1回だけで、以降は同じ状態を進める
+    double playout(const std::shared_ptr<SimultaneousState> &state)
+    {
+        auto now_state = state->clone();
+        ActionBuffer legal_actions0;
+        ActionBuffer legal_actions1;
+        while (!now_state->is_done())
+        {
+            now_state->legal_actions_into(0, legal_actions0);
+            now_state->legal_actions_into(1, legal_actions1);
+            if (legal_actions0.empty() || legal_actions1.empty())
+                break;
+            now_state->advance(legal_actions0[rng_.randrange(static_cast<int>(legal_actions0.size()))],
+                               legal_actions1[rng_.randrange(static_cast<int>(legal_actions1.size()))]);
+        }
+        return terminalValue(*now_state);
+    }
+
+    void expand(const int index)
+    {
+        ActionBuffer legal_actions[2];
+        for (int player_id = 0; player_id < 2; player_id++)
+        {
+            pool_[index].state->legal_actions_into(player_id, legal_actions[player_id]);
+            if (legal_actions[player_id].empty())
+                return;
+        }
+        const int count0 = static_cast<int>(legal_actions[0].size());
+        const int count1 = static_cast<int>(legal_actions[1].size());
+        const int first = pool_.allocate(count0 * count1);
+        if (first < 0)
+            return; // プールが一杯なら葉のままプレイアウトを続ける
+        for (int player_id = 0; player_id < 2; player_id++)
+        {
+            pool_[index].stats_offset[player_id] = static_cast<int>(stat_actions_.size());
+            pool_[index].action_count[player_id] = static_cast<int>(legal_actions[player_id].size());
+            for (const auto &action : legal_actions[player_id])
+            {
+                stat_actions_.emplace_back(action);
+                stat_w_.emplace_back(0.);
+                stat_n_.emplace_back(0);
+            }
+        }
+        for (int i0 = 0; i0 < count0; i0++)
+        {
+            for (int i1 = 0; i1 < count1; i1++)
+            {
+                auto &child = pool_[first + i0 * count1 + i1];
+                child.action0 = legal_actions[0][i0];
+                child.action1 = legal_actions[1][i1];
+            }
+        }
+        pool_[index].first_child = first;
+        pool_[index].child_count = count0 * count1;
+    }
+
+    // プレイヤーの統計量だけを見てUCB1で行動の添字を選ぶ
+    int selectAction(const int index, const int player_id) const
+    {
+        const auto &node = pool_[index];
+        const int offset = node.stats_offset[player_id];
+        const double log_n = std::log(static_cast<double>(node.n));
+        int best = 0;
+        double best_ucb = -std::numeric_limits<double>::infinity();
+        for (int i = 0; i < node.action_count[player_id]; i++)
+        {
+            const int n = stat_n_[offset + i];
+            if (n == 0)
+                return i;
+            const double ucb = stat_w_[offset + i] / n + c_ * std::sqrt(2. * log_n / n);
+            if (ucb > best_ucb)
+            {
+                best_ucb = ucb;
+                best = i;
+            }
+        }
+        return best;
+    }
+
+    // ノードを評価し、プレイヤー0から見た価値を返す
+    double evaluate(const int index)
+    {
+        double value;
+        if (pool_[index].state->is_done())
+        {
+            value = terminalValue(*pool_[index].state);
+        }
+        else if (!pool_[index].isExpanded())
+        {
+            value = playout(pool_[index].state);
+            if (pool_[index].n + 1 >= expand_threshold_)
+                expand(index);
+        }
+        else
+        {
+            const int i0 = selectAction(index, 0);
+            const int i1 = selectAction(index, 1);
+            const int child = pool_[index].first_child + i0 * pool_[index].action_count[1] + i1;
+            if (pool_[child].state == nullptr)
+            {
+                pool_[child].state = pool_[index].state->clone();
+                pool_[child].state->advance(pool_[child].action0, pool_[child].action1);
+            }
+            value = evaluate(child);
+            const int offset0 = pool_[index].stats_offset[0] + i0;
+            const int offset1 = pool_[index].stats_offset[1] + i1;
+            stat_w_[offset0] += value;
+            stat_n_[offset0]++;
+            stat_w_[offset1] += 1. - value;
+            stat_n_[offset1]++;
+        }
+        pool_[index].n++;
+        return value;
+    }
+
+public:
+    DuctSearcher(const double c, const int expand_threshold, const int node_limit, const uint64_t seed)
+        : pool_(node_limit), rng_(seed), c_(c), expand_threshold_(expand_threshold)
+    {
+        const std::size_t stat_limit = 2 * static_cast<std::size_t>(pool_.capacity());
+        stat_actions_.reserve(stat_limit);
+        stat_w_.reserve(stat_limit);
+        stat_n_.reserve(stat_limit);
+    }
+
+    // 反復回数か制限時間(ミリ秒)の範囲で探索し、player_idのプレイヤーが最も多く選んだ行動を返す
+    int search(std::shared_ptr<SimultaneousState> state, const int player_id, const int64_t playout_number, const int64_t time_limit)
+    {
+        checkSearchLimit(playout_number, time_limit);
+        if (player_id != 0 && player_id != 1)
+            throw std::invalid_argument("player_id must be 0 or 1");
+        pool_.clear();
+        stat_actions_.clear();
+        stat_w_.clear();
+        stat_n_.clear();
+        pool_.allocate(1);
+        pool_[0].state = state->clone();
+        expand(0);
+        if (!pool_[0].isExpanded())
+            throw std::invalid_argument("state has no legal actions");
+
+        TimeKeeper time_keeper(time_limit);
+        for (int64_t i = 0; playout_number <= 0 || i < playout_number; i++)
+        {
+            if (time_keeper.isTimeOver())
+                break;
+            evaluate(0);
+        }
+
+        const auto &root = pool_[0];
+        const int offset = root.stats_offset[player_id];
+        int best = 0;
+        for (int i = 1; i < root.action_count[player_id]; i++)
+            if (stat_n_[offset + i] > stat_n_[offset + best])
+                best = i;
+        return stat_actions_[offset + best];
+    }
+};
+
+// 反復回数か制限時間(ミリ秒)を指定してDUCTでplayer_idのプレイヤーの行動を決定する
+inline int ductAction(std::shared_ptr<SimultaneousState> state, const int player_id, const int64_t playout_number, const int64_t time_limit,
+                      const double c, const int expand_threshold, const int node_limit, const uint64_t seed)
+{
+    DuctSearcher searcher(c, expand_threshold, node_limit, seed);
+    return searcher.search(state, player_id, playout_number, time_limit);
+}
@@ -1,5 +1,5 @@
 import sys
-from typing import List, Callable, Set
+from typing import List, Callable, Optional, Set, Tuple
 from copy import deepcopy
 from ._thunsearch import *
 _thun = _thunsearch
@@ -51,54 +51,67 @@ def _get_functions(obj):
     return {k for k, v in obj.__dict__.items() if type(v).__name__ == "function"}
 
 
-class BaseContextualState(_thun.ContextualState):
-    """Abstract Class for Beam Search
-
-    If this class is inherited
-    and virtual functions are implemented appropriately,
-    time series information-based search algorithms
-    such as beam search can be applied.
+class _LabeledState:
+    """Mixin for base state classes whose functions are labeled
 
+    The class that directly inherits this mixin is the base class,
+    and its functions labeled "must", "should" and "can" are checked
+    against the subclass implemented by the user.
     """
 
     def __new__(cls, *args, **kwargs):
         """Create a instance while checking whether functions labeled "must" are implemented.
         """
-        must_functions = (_get_labeled_functions(__class__, "__must__"))
-        sub_functions = (_get_functions(cls))
-
-        not_implemented_musts = must_functions-sub_functions
+        not_implemented_musts = cls.get_not_implemented_must_methods()
         if len(not_implemented_musts) > 0:
             joined_musts = " , ".join([k for k in list(not_implemented_musts)])
             raise NotImplementedError(
                 f"must functions are not implemented. [{joined_musts}] ")
-        return super(__class__, cls).__new__(cls, *args, **kwargs)
-
-    def _legal_actions(self) -> _thun.VectorInt:
-        return _thun.VectorInt(self.legal_actions())
+        return super().__new__(cls, *args, **kwargs)
 
     def __init_subclass__(cls, /,  **kwargs):
         super().__init_subclass__(**kwargs)
         cls.sub_cls = cls
 
+    @classmethod
+    def _get_base_class(cls):
+        return next(c for c in cls.__mro__ if _LabeledState in c.__bases__)
+
     @classmethod
     def get_not_implemented_must_methods(cls) -> Set[str]:
-        base_functions = _get_labeled_functions(__class__, "__must__")
+        base_functions = _get_labeled_functions(
+            cls._get_base_class(), "__must__")
         sub_functions = _get_functions(cls)
         return base_functions-sub_functions
 
     @classmethod
     def get_not_implemented_should_methods(cls) -> Set[str]:
-        base_functions = _get_labeled_functions(__class__, "__should__")
+        base_functions = _get_labeled_functions(
+            cls._get_base_class(), "__should__")
         sub_functions = _get_functions(cls)
         return base_functions-sub_functions
 
     @classmethod
     def get_not_implemented_can_methods(cls) -> Set[str]:
-        base_functions = _get_labeled_functions(__class__, "__can__")
+        base_functions = _get_labeled_functions(
+            cls._get_base_class(), "__can__")
         sub_functions = _get_functions(cls)
         return base_functions-sub_functions
 
+
+class BaseContextualState(_LabeledState, _thun.ContextualState):
+    """Abstract Class for Beam Search
+
+    If this class is inherited
+    and virtual functions are implemented appropriately,
+    time series information-based search algorithms
+    such as beam search can be applied.
+
+    """
+
+    def _legal_actions(self) -> _thun.VectorInt:
+        return _thun.VectorInt(self.legal_actions())
+
     @must
     def advance(self, action: int) -> None:
         """Advance state by action
@@ -204,6 +217,130 @@ class BaseContextualState(_thun.ContextualState):
         """
         return False
 
+    @can
+    def hash(self) -> int:
+        """Hash value used to identify the state
+
+        Used by searches that detect duplicate states
+        such as best_first_action.
+        If not overridden by a subclass,
+        the hash of str(self) is returned.
+
+        Label
+        ----------
+        "can": Can be overided.
+
+        Returns
+        -------
+        int
+            hash value
+        """
+        return hash(str(self))
+
+    @can
+    def step_cost(self, action: int) -> float:
+        """Cost of taking action in this state
+
+        Used by best_first_action.
+        If not overridden by a subclass, always returns 1.0.
+
+        Label
+        ----------
+        "can": Can be overided.
+
+        Parameters
+        ----------
+        action: int
+
+        Returns
+        -------
+        float
+            cost
+        """
+        return 1.0
+
+    @can
+    def heuristic(self) -> float:
+        """Estimate of the remaining cost to a done state
+
+        Used by best_first_action.
+        If it never overestimates,
+        best_first_action with weight 1.0 finds a cheapest solution.
+        If not overridden by a subclass, always returns 0.0.
+
+        Label
+        ----------
+        "can": Can be overided.
+
+        Returns
+        -------
+        float
+            estimated remaining cost
+        """
+        return 0.0
+
+    @can
+    def action_weights(self) -> Optional[List[float]]:
+        """Weights of legal actions used by random playouts
+
+        Used by randomAction, random_rollouts
+        and nested_monte_carlo_action.
+        An action is chosen with probability proportional to its weight.
+        The weights must be in the same order as legal_actions().
+        If None is returned, the rest of the playout
+        does not call this method again
+        and falls back to the action_weights argument of the search,
+        or to uniform choice.
+        If not overridden by a subclass, always returns None.
+
+        Label
+        ----------
+        "can": Can be overided.
+
+        Returns
+        -------
+        List[float] or None
+            non-negative weight of each legal action
+        """
+        return None
+
+    @can
+    def step(self, action: int) -> Tuple["BaseContextualState", float,
+                                         bool, bool]:
+        """Advance a clone by action and evaluate it in one call
+
+        If overridden by a subclass, searches such as beam_search_action
+        call this once per child instead of calling clone, advance,
+        is_dead, evaluate_score and is_done one by one from C++.
+        Override it to compute these together, e.g. to return
+        without evaluating when the child is dead.
+        If not overridden by a subclass, the searches do not call it
+        and call those methods from C++ in that order.
+        Calling this implementation directly makes the same calls.
+
+        Label
+        ----------
+        "can": Can be overided.
+
+        Parameters
+        ----------
+        action: int
+
+        Returns
+        -------
+        Tuple[SubClass, float, bool, bool]
+            (child, evaluate_score(), is_done(), is_dead()) of the child.
+            The score and done are ignored when the child is dead.
+        """
+        child = self.clone()
+        child.advance(action)
+        if child.is_dead():
+            return child, 0.0, False, True
+        return child, child.evaluate_score(), child.is_done(), False
+
+    # C++側はこの印のあるstepを実装されていないものとして扱う
+    step.__default_step__ = True
+
     @can
     def __str__(self) -> str:
         """Convert to string
@@ -254,22 +391,1464 @@ class BaseContextualState(_thun.ContextualState):
         return cloned
 
 
-def beam_search_action(state: BaseContextualState, beam_width: int) -> List[int]:
-    """Decide actions by beam search.
+class BaseNonContextualState(_LabeledState, _thun.NonContextualState):
+    """Abstract Class for Hill Climbing
 
-    Parameters
-    ----------
-    Subclass inheriting from BaseContextualState
-        state
-    int
-        beam_width
+    If this class is inherited
+    and virtual functions are implemented appropriately,
+    search algorithms that improve a whole solution
+    such as hill climbing can be applied.
 
-    Returns
-    -------
-    List[int]
-        List of actions to be taken until the task is completed
+    If delta_score is also implemented,
+    moves can be judged without cloning the state.
+    """
+
+    @must
+    def neighbor(self, rng: RandomGenerator) -> int:
+        """Choose a move to a neighbor without changing the state
+
+        Label
+        ----------
+        "must": Must be implemented.
+
+        Parameters
+        ----------
+        rng: RandomGenerator
+            random generator owned by the search
+
+        Returns
+        -------
+        int
+            move passed to transition and delta_score
+        """
+        raise NotImplementedError(
+            f"{sys._getframe().f_code.co_name} is not implemented")
+
+    @must
+    def transition(self, move: int) -> None:
+        """Apply the move chosen by neighbor
+
+        Label
+        ----------
+        "must": Must be implemented.
+
+        Parameters
+        ----------
+        move: int
+
+
+        Returns
+        -------
+        None
+        """
+        raise NotImplementedError(
+            f"{sys._getframe().f_code.co_name} is not implemented")
+
+    @must
+    def evaluate_score(self) -> float:
+        """evaluate score and return
+
+        Label
+        ----------
+        "must": Must be implemented.
+
+        Parameters
+        ----------
+        None
+
+
+        Returns
+        -------
+        float
+            evaluated_score
+        """
+        raise NotImplementedError(
+            f"{sys._getframe().f_code.co_name} is not implemented")
+
+    @can
+    def delta_score(self, move: int) -> float:
+        """Return how much evaluate_score would change by the move
+
+        The state must not be changed.
+        If not overridden by a subclass,
+        the search clones the state and calls evaluate_score instead.
+
+        Label
+        ----------
+        "can": Can be overided.
+
+        Parameters
+        ----------
+        move: int
+
+
+        Returns
+        -------
+        float
+            evaluated_score after the move - evaluated_score now
+        """
+        raise NotImplementedError(
+            f"{sys._getframe().f_code.co_name} is not implemented")
+
+    def has_delta_score(self) -> bool:
+        return "delta_score" not in self.get_not_implemented_can_methods()
+
+    def _neighborhood(self) -> _thun.VectorInt:
+        return _thun.VectorInt(self.neighborhood())
+
+    @can
+    def neighborhood(self) -> List[int]:
+        """Return all moves that can be applied to the state now
+
+        Needed by searches that evaluate the whole neighborhood
+        such as tabu_search.
+
+        Label
+        ----------
+        "can": Can be overided.
+
+        Returns
+        -------
+        List[int]
+            moves
+        """
+        raise NotImplementedError(
+            f"{sys._getframe().f_code.co_name} is not implemented")
+
+    @can
+    def move_attribute(self, move: int) -> int:
+        """Return the attribute of the move kept in the tabu list
+
+        tabu_search forbids moves with the same attribute
+        as a recently applied move.
+        For example, return the index of the changed element
+        to forbid changing it again soon.
+        If not overridden by a subclass, the move itself is returned.
+
+        Label
+        ----------
+        "can": Can be overided.
+
+        Parameters
+        ----------
+        move: int
+
+        Returns
+        -------
+        int
+            attribute
+        """
+        return move
+
+    @can
+    def __str__(self) -> str:
+        """Convert to string
+
+        If not overridden by a subclass,
+        just connect all member variables as str.
+
+        Label
+        ----------
+        "can": Can be overided.
+
+        Returns
+        -------
+        str
+            state information
+        """
+        ret_s = ""
+        for key, value in self.__dict__.items():
+            ret_s += f"{key}:"
+            if hasattr(value, "__str__"):
+                ret_s += f"{value}"
+            ret_s += "\n"
+        return ret_s
+
+    @can
+    def clone(self):
+        """Clone object that inherit BaseClass
+
+        If not overridden by a subclass,
+        clone instance as deepcopy
+
+        Label
+        ----------
+        "can": Can be overided.
+
+        Returns
+        -------
+        SubClass
+            cloned instance
+        """
+        # sub_cls is Class that inherit BaseClass
+        cloned = self.sub_cls.__new__(self.sub_cls)
+        # clone C++ state
+        _thun.NonContextualState.__init__(cloned, self)
+        # clone Python state
+        cloned.__dict__ = {key: deepcopy(value)
+                           for key, value in self.__dict__.items()}
+        return cloned
+
+
+class BaseGeneticState(_LabeledState, _thun.GeneticState):
+    """Abstract Class for Genetic Algorithm
+
+    If this class is inherited
+    and virtual functions are implemented appropriately,
+    a population of this class can be evolved by genetic algorithm.
+    """
+
+    @must
+    def crossover(self, other, rng: RandomGenerator):
+        """Create a child from self and other
+
+        The parents must not be changed.
+
+        Label
+        ----------
+        "must": Must be implemented.
+
+        Parameters
+        ----------
+        other: Subclass inheriting from BaseGeneticState
+            the other parent
+        rng: RandomGenerator
+            random generator owned by the search
+
+        Returns
+        -------
+        Subclass inheriting from BaseGeneticState
+            new child
+        """
+        raise NotImplementedError(
+            f"{sys._getframe().f_code.co_name} is not implemented")
+
+    @must
+    def mutate(self, rng: RandomGenerator) -> None:
+        """Mutate self
+
+        Label
+        ----------
+        "must": Must be implemented.
+
+        Parameters
+        ----------
+        rng: RandomGenerator
+            random generator owned by the search
+
+        Returns
+        -------
+        None
+        """
+        raise NotImplementedError(
+            f"{sys._getframe().f_code.co_name} is not implemented")
+
+    @must
+    def evaluate_score(self) -> float:
+        """evaluate score and return
+
+        Label
+        ----------
+        "must": Must be implemented.
+
+        Parameters
+        ----------
+        None
+
+
+        Returns
+        -------
+        float
+            evaluated_score
+        """
+        raise NotImplementedError(
+            f"{sys._getframe().f_code.co_name} is not implemented")
+
+    @can
+    def __str__(self) -> str:
+        """Convert to string
+
+        If not overridden by a subclass,
+        just connect all member variables as str.
+
+        Label
+        ----------
+        "can": Can be overided.
+
+        Returns
+        -------
+        str
+            state information
+        """
+        ret_s = ""
+        for key, value in self.__dict__.items():
+            ret_s += f"{key}:"
+            if hasattr(value, "__str__"):
+                ret_s += f"{value}"
+            ret_s += "\n"
+        return ret_s
+
+    @can
+    def clone(self):
+        """Clone object that inherit BaseClass
+
+        If not overridden by a subclass,
+        clone instance as deepcopy
+
+        Label
+        ----------
+        "can": Can be overided.
+
+        Returns
+        -------
+        SubClass
+            cloned instance
+        """
+        # sub_cls is Class that inherit BaseClass
+        cloned = self.sub_cls.__new__(self.sub_cls)
+        # clone C++ state
+        _thun.GeneticState.__init__(cloned, self)
+        # clone Python state
+        cloned.__dict__ = {key: deepcopy(value)
+                           for key, value in self.__dict__.items()}
+        return cloned
+
+
+class BaseAlternateState(_LabeledState, _thun.AlternateState):
+    """Abstract Class for Alternate Games
+
+    If this class is inherited
+    and virtual functions are implemented appropriately,
+    search algorithms for two-player games where players move alternately
+    such as alpha-beta can be applied.
+    """
+
+    def _legal_actions(self) -> _thun.VectorInt:
+        return _thun.VectorInt(self.legal_actions())
+
+    @must
+    def advance(self, action: int) -> None:
+        """Advance state by action of the player to move
+
+        Label
+        ----------
+        "must": Must be implemented.
+
+        Parameters
+        ----------
+        action: int
+
+
+        Returns
+        -------
+        None
+        """
+        raise NotImplementedError(
+            f"{sys._getframe().f_code.co_name} is not implemented")
+
+    @must
+    def legal_actions(self) -> List[int]:
+        """Get legal actions of the player to move
+
+        Label
+        ----------
+        "must": Must be implemented.
+
+        Parameters
+        ----------
+        None
+
+
+        Returns
+        -------
+        List[int]
+            actions
+        """
+        raise NotImplementedError(
+            f"{sys._getframe().f_code.co_name} is not implemented")
+
+    @must
+    def is_done(self) -> bool:
+        """Check game is over
+
+        Label
+        ----------
+        "must": Must be implemented.
+
+        Parameters
+        ----------
+        None
+
+
+        Returns
+        -------
+        bool
+            Whether the game is over
+        """
+        raise NotImplementedError(
+            f"{sys._getframe().f_code.co_name} is not implemented")
+
+    @must
+    def evaluate_score(self) -> float:
+        """evaluate score from the viewpoint of the player to move and return
+
+        The larger the score, the better for the player to move.
+
+        Label
+        ----------
+        "must": Must be implemented.
+
+        Parameters
+        ----------
+        None
+
+
+        Returns
+        -------
+        float
+            evaluated_score
+        """
+        raise NotImplementedError(
+            f"{sys._getframe().f_code.co_name} is not implemented")
+
+    @can
+    def hash(self) -> int:
+        """Hash value used to identify the state
+
+        The state must include the player to move.
+        If not overridden by a subclass,
+        the hash of str(self) is returned.
+
+        Label
+        ----------
+        "can": Can be overided.
+
+        Returns
+        -------
+        int
+            hash value
+        """
+        return hash(str(self))
+
+    @can
+    def __str__(self) -> str:
+        """Convert to string
+
+        If not overridden by a subclass,
+        just connect all member variables as str.
+
+        Label
+        ----------
+        "can": Can be overided.
+
+        Returns
+        -------
+        str
+            state information
+        """
+        ret_s = ""
+        for key, value in self.__dict__.items():
+            ret_s += f"{key}:"
+            if hasattr(value, "__str__"):
+                ret_s += f"{value}"
+            ret_s += "\n"
+        return ret_s
+
+    @can
+    def clone(self):
+        """Clone object that inherit BaseClass
+
+        If not overridden by a subclass,
+        clone instance as deepcopy
+
+        Label
+        ----------
+        "can": Can be overided.
+
+        Returns
+        -------
+        SubClass
+            cloned instance
+        """
+        # sub_cls is Class that inherit BaseClass
+        cloned = self.sub_cls.__new__(self.sub_cls)
+        # clone C++ state
+        _thun.AlternateState.__init__(cloned, self)
+        # clone Python state
+        cloned.__dict__ = {key: deepcopy(value)
+                           for key, value in self.__dict__.items()}
+        return cloned
+
+
+class BaseSimultaneousState(_LabeledState, _thun.SimultaneousState):
+    """Abstract Class for Simultaneous Games
+
+    If this class is inherited
+    and virtual functions are implemented appropriately,
+    search algorithms for two-player games where players move simultaneously
+    such as decoupled UCT can be applied.
+    """
+
+    def _legal_actions(self, player_id: int) -> _thun.VectorInt:
+        return _thun.VectorInt(self.legal_actions(player_id))
+
+    @must
+    def advance(self, action0: int, action1: int) -> None:
+        """Advance state by actions of both players
+
+        Label
+        ----------
+        "must": Must be implemented.
+
+        Parameters
+        ----------
+        action0: int
+            action of player 0
+        action1: int
+            action of player 1
+
+        Returns
+        -------
+        None
+        """
+        raise NotImplementedError(
+            f"{sys._getframe().f_code.co_name} is not implemented")
+
+    @must
+    def legal_actions(self, player_id: int) -> List[int]:
+        """Get legal actions of a player
+
+        Label
+        ----------
+        "must": Must be implemented.
+
+        Parameters
+        ----------
+        player_id: int
+            0 or 1
+
+        Returns
+        -------
+        List[int]
+            actions
+        """
+        raise NotImplementedError(
+            f"{sys._getframe().f_code.co_name} is not implemented")
+
+    @must
+    def is_done(self) -> bool:
+        """Check game is over
+
+        Label
+        ----------
+        "must": Must be implemented.
+
+        Parameters
+        ----------
+        None
+
+
+        Returns
+        -------
+        bool
+            Whether the game is over
+        """
+        raise NotImplementedError(
+            f"{sys._getframe().f_code.co_name} is not implemented")
+
+    @must
+    def evaluate_score(self) -> float:
+        """evaluate score from the viewpoint of player 0 and return
+
+        The larger the score, the better for player 0.
+
+        Label
+        ----------
+        "must": Must be implemented.
+
+        Parameters
+        ----------
+        None
+
+
+        Returns
+        -------
+        float
+            evaluated_score
+        """
+        raise NotImplementedError(
+            f"{sys._getframe().f_code.co_name} is not implemented")
+
+    @can
+    def __str__(self) -> str:
+        """Convert to string
+
+        If not overridden by a subclass,
+        just connect all member variables as str.
+
+        Label
+        ----------
+        "can": Can be overided.
+
+        Returns
+        -------
+        str
+            state information
+        """
+        ret_s = ""
+        for key, value in self.__dict__.items():
+            ret_s += f"{key}:"
+            if hasattr(value, "__str__"):
+                ret_s += f"{value}"
+            ret_s += "\n"
+        return ret_s
+
+    @can
+    def clone(self):
+        """Clone object that inherit BaseClass
+
+        If not overridden by a subclass,
+        clone instance as deepcopy
+
+        Label
+        ----------
+        "can": Can be overided.
+
+        Returns
+        -------
+        SubClass
+            cloned instance
+        """
+        # sub_cls is Class that inherit BaseClass
+        cloned = self.sub_cls.__new__(self.sub_cls)
+        # clone C++ state
+        _thun.SimultaneousState.__init__(cloned, self)
+        # clone Python state
+        cloned.__dict__ = {key: deepcopy(value)
+                           for key, value in self.__dict__.items()}
+        return cloned
+
+
+def beam_search_action(state: BaseContextualState, beam_width: int,
+                       memory_stats: SearchMemoryStats = None,
+                       cache: EvaluationCache = None,
+                       result: SearchResult = None) -> List[int]:
+    """Decide actions by beam search.
+
+    Parameters
+    ----------
+    Subclass inheriting from BaseContextualState
+        state
+    int
+        beam_width
+    SearchMemoryStats
+        memory_stats (optional)
+        If given, it is filled with the memory usage of this search.
+    EvaluationCache
+        cache (optional)
+        If given, evaluate_score() is looked up by hash() first,
+        and the cache keeps its entries across calls.
+    SearchResult
+        result (optional)
+        If given, it is filled with the actions, the score
+        and the statistics of this search.
+
+    Returns
+    -------
+    List[int]
+        List of actions to be taken until the task is completed
+    """
+    return _thun.beamSearchAction(state, beam_width, memory_stats, cache,
+                                  result)
+
+
+def random_rollouts(state: BaseContextualState, n: int, threads: int = 1,
+                    seed: Optional[int] = None, keep_best: bool = False,
+                    action_weights: Optional[List[float]] = None
+                    ) -> Tuple["numpy.ndarray", "numpy.ndarray",
+                               Optional[List[int]]]:
+    """Play n random playouts from state in one call.
+
+    The i-th playout uses a random stream determined by seed and i,
+    so the results do not depend on threads.
+    The GIL is released while playing,
+    but every call into a Python state acquires it again,
+    so a state implemented in Python gains little from threads.
+
+    Parameters
+    ----------
+    Subclass inheriting from BaseContextualState
+        state
+    int
+        n
+        Number of playouts.
+    int
+        threads
+    Optional[int]
+        seed
+        Seed of the random generator. The same seed gives the same result.
+        None draws a new seed on every call.
+    bool
+        keep_best
+        If True, the actions of the playout with the highest score
+        are also returned.
+    List[float] or None
+        action_weights
+        Weight of each action, indexed by the action.
+        Actions are chosen with probability proportional to it
+        when state.action_weights() returns None.
+        Actions outside the list have weight 0.
+
+    Returns
+    -------
+    numpy.ndarray
+        evaluate_score() of the last state of each playout (float64),
+        or -inf if the playout ended in a dead state
+    numpy.ndarray
+        Number of actions of each playout (int32)
+    List[int] or None
+        Actions of the best playout if keep_best, otherwise None
+    """
+    if action_weights is None:
+        action_weights = []
+    return _thun.randomRollouts(state, n, threads, seed, keep_best,
+                                action_weights)
+
+
+def beam_stack_search_action(
+        state: BaseContextualState, beam_width: int, time_limit: int = 0,
+        on_improve: Callable[[List[int], float], None] = None,
+        cache: EvaluationCache = None,
+        result: SearchResult = None, max_depth: int = 0,
+        score_bound: bool = False) -> List[int]:
+    """Decide actions by beam stack search.
+
+    Each depth keeps the best beam_width states like beam search
+    and remembers the rank of the worst one kept.
+    When everything below a depth has been searched,
+    the depth is rebuilt from the states pruned there.
+    With a finite depth every state is eventually searched,
+    while memory stays within depth * beam_width states.
+
+    The search only ends by itself when the whole space has been searched.
+    Without time_limit or max_depth, a problem whose depth is unbounded
+    (for example one with cycles) never returns, and a finite problem
+    is searched exhaustively unless score_bound prunes it.
+
+    Parameters
+    ----------
+    Subclass inheriting from BaseContextualState
+        state
+    int
+        beam_width
+    int
+        time_limit
+        Time limit in milliseconds. 0 means no limit.
+        When the time is over, the best solution found so far is returned.
+    Callable[[List[int], float], None]
+        on_improve (optional)
+        Called with the actions and the score
+        whenever a better done state is found.
+    EvaluationCache
+        cache (optional)
+        If given, evaluate_score() is looked up by hash() first,
+        and the cache keeps its entries across calls.
+    SearchResult
+        result (optional)
+        If given, it is filled with the actions, the score
+        and the statistics of this search.
+    int
+        max_depth (optional)
+        States at this depth are not expanded. 0 means no limit.
+    bool
+        score_bound (optional)
+        Set this when evaluate_score() is an upper bound of the score
+        of every done state below it. Children that cannot beat the best
+        done state found so far are pruned, and depths that only have
+        such states left are not rebuilt.
+
+    Returns
+    -------
+    List[int]
+        List of actions to the best done state.
+        If no done state is found,
+        list of actions to the best state reached.
+    """
+    return _thun.beamStackSearchAction(state, beam_width, time_limit,
+                                       on_improve, cache, result, max_depth,
+                                       score_bound)
+
+
+class SearchSession(_thun.SearchSession):
+    """Beam search that keeps its work across turns.
+
+    Bots that run beam search every turn can keep one session
+    instead of calling beam_search_action each time.
+    The session owns an EvaluationCache and its buffers across calls,
+    and skips states with the same hash() within a depth.
+    It also keeps the beams of the previous search:
+    if the new state is one of them, the states below it
+    are carried over to the new search,
+    and the previous solution is kept
+    if the new search does not find a better one.
+
+    The state must implement the "can" method hash().
+    Children are created as in beam_search_action,
+    and search() also calls hash() once for every child
+    and once for the root,
+    so with a Python state each child costs one more Python call
+    than in beam_search_action without a cache.
+    If step() is not overridden, a cache hit saves
+    the evaluate_score() call of that child.
+    States are identified by hash() alone:
+    if the new root collides with a different state of the previous
+    search, the descendants of that state are reused by mistake.
+
+    Parameters
+    ----------
+    int
+        beam_width
+    int
+        cache_capacity (optional)
+        Number of scores the evaluation cache can hold.
+    int
+        ways (optional)
+        Associativity of the evaluation cache.
+
+    Attributes
+    ----------
+    EvaluationCache
+        cache
+        The evaluation cache owned by the session.
+    int
+        reused_states
+        Number of states the last search carried over
+        from the previous one.
+    """
+
+    def __init__(self, beam_width: int, cache_capacity: int = 1 << 16,
+                 ways: int = 4) -> None:
+        super().__init__(beam_width, cache_capacity, ways)
+
+    def search(self, state: BaseContextualState,
+               result: SearchResult = None) -> List[int]:
+        """Decide actions by beam search from state.
+
+        Parameters
+        ----------
+        Subclass inheriting from BaseContextualState
+            state
+        SearchResult
+            result (optional)
+            If given, it is filled with the actions, the score
+            and the statistics of this search.
+
+        Returns
+        -------
+        List[int]
+            List of actions to the best done state.
+            If no done state is found,
+            list of actions to the best state of the last depth.
+        """
+        return super().search(state, result)
+
+    def reset(self) -> None:
+        """Forget the previous search and clear the cache."""
+        super().reset()
+
+
+def best_first_action(state: BaseContextualState, weight: float = 1.0,
+                      node_limit: int = 100000,
+                      time_limit: int = 0) -> List[int]:
+    """Decide actions by weighted A* search.
+
+    States are expanded in increasing order of
+    g + weight * h, where g is the sum of step_cost from state
+    and h is heuristic().
+    The first done state taken out is returned,
+    and states with the same hash() are opened again only with a smaller g.
+    Only the states waiting to be expanded and the expanded states
+    whose children are still kept are held in memory.
+    When they exceed node_limit, the worst waiting states are dropped
+    and forgotten, and a parent whose children are all dropped
+    waits to be expanded again, so they are regenerated later.
+    The search stops when no state that can reach a done state is left.
+
+    Parameters
+    ----------
+    Subclass inheriting from BaseContextualState
+        state
+    float
+        weight
+        Weight of the heuristic.
+        1.0 gives A* and larger values find a solution faster.
+    int
+        node_limit
+        Maximum number of states held in memory. At least 4.
+    int
+        time_limit
+        Time limit in milliseconds. 0 means no limit.
+
+    Returns
+    -------
+    List[int]
+        List of actions to the done state.
+        If no done state is found,
+        list of actions to the state with the smallest heuristic().
+    """
+    return _thun.bestFirstAction(state, weight, node_limit, time_limit)
+
+
+def nested_monte_carlo_action(state: BaseContextualState, level: int,
+                              time_limit: int = 0, seed: Optional[int] = None,
+                              action_weights: Optional[List[float]] = None
+                              ) -> List[int]:
+    """Decide actions by nested Monte Carlo search.
+
+    At every step each action is tried with a search of level - 1
+    (level 0 is a random playout)
+    and the best sequence found so far is followed.
+    The number of playouts grows with the branching factor
+    to the power of level, so level 1 or 2 is usually enough.
+
+    Parameters
+    ----------
+    Subclass inheriting from BaseContextualState
+        state
+    int
+        level
+        Nesting level. Must be positive.
+    int
+        time_limit
+        Time limit in milliseconds. 0 means no limit.
+        When the time is over, the best sequence found so far is returned.
+    Optional[int]
+        seed
+        Seed of the random generator. The same seed gives the same result.
+        None draws a new seed on every call.
+    List[float] or None
+        action_weights
+        Weight of each action, indexed by the action.
+        Playouts choose actions with probability proportional to it
+        when state.action_weights() returns None.
+        Actions outside the list have weight 0.
+
+    Returns
+    -------
+    List[int]
+        List of actions to be taken until the task is completed
+    """
+    if action_weights is None:
+        action_weights = []
+    return _thun.nestedMonteCarloAction(state, level, time_limit, seed,
+                                        action_weights)
+
+
+def nrpa_action(state: BaseContextualState, level: int,
+                iterations: int = 100, alpha: float = 1.0,
+                time_limit: int = 0, seed: Optional[int] = None) -> List[int]:
+    """Decide actions by nested rollout policy adaptation (NRPA).
+
+    Playouts choose actions with probabilities given by a policy,
+    and each level adapts its copy of the policy
+    toward the best sequence found by the level below.
+    The policy is keyed by the pair of step and action.
+
+    Parameters
+    ----------
+    Subclass inheriting from BaseContextualState
+        state
+    int
+        level
+        Nesting level. Must be positive.
+        A search of level L runs iterations to the power of L playouts.
+    int
+        iterations
+        Number of searches of level - 1 on each level.
+    float
+        alpha
+        Learning rate of the policy.
+    int
+        time_limit
+        Time limit in milliseconds. 0 means no limit.
+        When the time is over, the best sequence found so far is returned.
+    Optional[int]
+        seed
+        Seed of the random generator. The same seed gives the same result.
+        None draws a new seed on every call.
+
+    Returns
+    -------
+    List[int]
+        List of actions to be taken until the task is completed
+    """
+    return _thun.nrpaAction(state, level, iterations, alpha, time_limit,
+                           seed)
+
+
+def hill_climb(state: BaseNonContextualState, iterations: int,
+               time_limit: int = 0,
+               seed: Optional[int] = None) -> BaseNonContextualState:
+    """Improve a state by hill climbing.
+
+    A move is accepted only when it improves evaluate_score.
+    The search stops when either limit is reached.
+
+    Parameters
+    ----------
+    Subclass inheriting from BaseNonContextualState
+        state
+    int
+        iterations
+        Number of moves to try. 0 means no limit.
+    int
+        time_limit
+        Time limit in milliseconds. 0 means no limit.
+    Optional[int]
+        seed
+        Seed of the random generator. The same seed gives the same result.
+        None draws a new seed on every call.
+
+    Returns
+    -------
+    Subclass inheriting from BaseNonContextualState
+        Improved copy of the state
+    """
+    return _thun.hillClimb(state, iterations, time_limit, seed)
+
+
+def tabu_search(state: BaseNonContextualState, iterations: int,
+                time_limit: int = 0,
+                tenure: int = 7) -> BaseNonContextualState:
+    """Improve state by tabu search.
+
+    Every iteration evaluates all moves of neighborhood()
+    and applies the best one that is not tabu, even if it is worse.
+    The attribute of an applied move is tabu for tenure iterations,
+    unless the move improves on the best state found so far.
+    neighborhood() must be implemented.
+    If delta_score is implemented, moves are evaluated without cloning.
+
+    Parameters
+    ----------
+    Subclass inheriting from BaseNonContextualState
+        state
+    int
+        iterations
+        Number of iterations. 0 means no limit.
+    int
+        time_limit
+        Time limit in milliseconds. 0 means no limit.
+    int
+        tenure
+        Number of iterations a move attribute stays tabu.
+
+    Returns
+    -------
+    Subclass inheriting from BaseNonContextualState
+        Best state found
+    """
+    return _thun.tabuSearch(state, iterations, time_limit, tenure)
+
+
+def simulated_annealing(state: BaseNonContextualState, start_temp: float,
+                        end_temp: float, time_limit: int,
+                        schedule=TemperatureSchedule.Exponential,
+                        iterations: int = 0,
+                        check_interval: int = 100,
+                        seed: Optional[int] = None) -> BaseNonContextualState:
+    """Improve a state by simulated annealing.
+
+    A worse move is accepted with probability exp(delta / temperature).
+    The clock is read and the temperature is updated
+    only once every check_interval moves.
+
+    Parameters
+    ----------
+    Subclass inheriting from BaseNonContextualState
+        state
+    float
+        start_temp
+    float
+        end_temp
+    int
+        time_limit
+        Time limit in milliseconds. 0 means no limit.
+    TemperatureSchedule or Callable[[float], float]
+        schedule
+        TemperatureSchedule.Linear, TemperatureSchedule.Exponential
+        or a function that takes the elapsed rate in [0, 1]
+        and returns the temperature.
+        If a function is given, start_temp and end_temp are ignored.
+    int
+        iterations
+        Number of moves to try. 0 means no limit.
+    int
+        check_interval
+    Optional[int]
+        seed
+        Seed of the random generator. The same seed gives the same result.
+        None draws a new seed on every call.
+
+    Returns
+    -------
+    Subclass inheriting from BaseNonContextualState
+        Best state found during the search
+    """
+    if callable(schedule):
+        return _thun.simulatedAnnealing(state, schedule, time_limit,
+                                        iterations, check_interval, seed)
+    return _thun.simulatedAnnealing(state, start_temp, end_temp, time_limit,
+                                    schedule, iterations, check_interval,
+                                    seed)
+
+
+def parallel_tempering(state: BaseNonContextualState, start_temp: float,
+                       end_temp: float, time_limit: int,
+                       iterations: int = 0, threads: int = 1,
+                       swap_interval: int = 1000,
+                       seed: Optional[int] = None) -> BaseNonContextualState:
+    """Improve a state by parallel tempering (replica exchange).
+
+    Each thread runs its own annealing chain at a fixed temperature.
+    The temperatures are spaced geometrically
+    from start_temp (hottest) to end_temp (coldest).
+    Every swap_interval moves all chains wait for each other
+    and neighbouring temperatures exchange their states
+    with the Metropolis probability.
+    The GIL is released while searching,
+    but every call into a Python state acquires it again,
+    so a state implemented in Python gains little from threads.
+
+    Parameters
+    ----------
+    Subclass inheriting from BaseNonContextualState
+        state
+    float
+        start_temp
+        Must be positive.
+    float
+        end_temp
+        Must be positive.
+    int
+        time_limit
+        Time limit in milliseconds. 0 means no limit.
+    int
+        iterations
+        Number of moves per chain. 0 means no limit.
+    int
+        threads
+        Number of chains, one per thread.
+    int
+        swap_interval
+        Number of moves between exchanges.
+        The time limit is also checked only at exchanges.
+    Optional[int]
+        seed
+        Each chain uses its own random stream split from seed.
+        None draws a new seed on every call.
+        The result still depends on timing when time_limit stops the search.
+
+    Returns
+    -------
+    Subclass inheriting from BaseNonContextualState
+        Best state found by any chain
+    """
+    return _thun.parallelTempering(state, start_temp, end_temp, time_limit,
+                                   iterations, threads, swap_interval, seed)
+
+
+def genetic_algorithm(population: List[BaseGeneticState], generations: int,
+                      time_limit: int = 0, islands: int = 1,
+                      migration_interval: int = 10, migration_size: int = 1,
+                      elite_size: int = 1, tournament_size: int = 3,
+                      mutation_rate: float = 0.2,
+                      threads: int = 1,
+                      seed: Optional[int] = None) -> BaseGeneticState:
+    """Evolve a population by genetic algorithm.
+
+    The population is divided into islands that evolve independently.
+    Every migration_interval generations,
+    the best individuals of each island replace
+    the worst individuals of the next island.
+    Evaluation and crossover run on a pool of threads.
+    Python individuals still run one at a time because of the GIL,
+    so threads only pay off for individuals implemented in C++.
+
+    Parameters
+    ----------
+    List[Subclass inheriting from BaseGeneticState]
+        population
+        Initial individuals. At least two per island are needed.
+    int
+        generations
+        Number of generations. 0 means no limit.
+    int
+        time_limit
+        Time limit in milliseconds. 0 means no limit.
+    int
+        islands
+    int
+        migration_interval
+    int
+        migration_size
+    int
+        elite_size
+        Number of best individuals kept as they are in each island.
+    int
+        tournament_size
+    float
+        mutation_rate
+        Probability that a child is mutated.
+    int
+        threads
+    Optional[int]
+        seed
+        Each island uses its own random stream split from seed,
+        so the result does not depend on threads.
+        None draws a new seed on every call.
+
+    Returns
+    -------
+    Subclass inheriting from BaseGeneticState
+        Best individual found
+    """
+    return _thun.geneticAlgorithm(population, generations, time_limit,
+                                  islands, migration_interval,
+                                  migration_size, elite_size,
+                                  tournament_size, mutation_rate, threads,
+                                  seed)
+
+
+def alpha_beta_action(state: BaseAlternateState, depth: int,
+                      time_limit: int = 0,
+                      table_size: int = 1 << 16) -> int:
+    """Decide action by alpha-beta search.
+
+    The search deepens iteratively from depth 1.
+    Results are kept in a transposition table keyed by state.hash(),
+    and the best action of the previous iteration is searched first.
+
+    Parameters
+    ----------
+    Subclass inheriting from BaseAlternateState
+        state
+    int
+        depth
+        Maximum depth. 0 means no limit.
+    int
+        time_limit
+        Time limit in milliseconds. 0 means no limit.
+        The iteration that runs out of time is discarded.
+    int
+        table_size
+        Number of entries of the transposition table.
+
+    Returns
+    -------
+    int
+        Action of the player to move
+    """
+    return _thun.alphaBetaAction(state, depth, time_limit, table_size)
+
+
+def mcts_action(state: BaseAlternateState, playout_number: int,
+                time_limit: int = 0, c: float = 1.0,
+                expand_threshold: int = 10,
+                node_limit: int = 100000, seed: Optional[int] = None) -> int:
+    """Decide action by Monte Carlo tree search (UCT).
+
+    Nodes are kept in a preallocated pool of node_limit nodes.
+    To reuse the tree over turns, use MctsSession instead:
+    call session.search(state, ...) to choose an action
+    and session.advance(action) for every action actually played.
+
+    Parameters
+    ----------
+    Subclass inheriting from BaseAlternateState
+        state
+    int
+        playout_number
+        Number of playouts. 0 means no limit.
+    int
+        time_limit
+        Time limit in milliseconds. 0 means no limit.
+    float
+        c
+        Exploration constant of UCB1.
+    int
+        expand_threshold
+        Number of visits before a node is expanded.
+    int
+        node_limit
+    Optional[int]
+        seed
+        Seed of the random generator. The same seed gives the same result.
+        None draws a new seed on every call.
+
+    Returns
+    -------
+    int
+        Action of the player to move
+    """
+    return _thun.mctsAction(state, playout_number, time_limit, c,
+                            expand_threshold, node_limit, seed)
+
+
+def thunder_search_action(state: BaseAlternateState, playout_number: int,
+                          time_limit: int = 0, score_scale: float = 1.0,
+                          expand_threshold: int = 1,
+                          node_limit: int = 100000,
+                          seed: Optional[int] = None) -> int:
+    """Decide action by Thunder search.
+
+    Thunder search is Monte Carlo tree search without playouts.
+    A leaf is valued by 1 / (1 + exp(-evaluate_score() / score_scale)),
+    unvisited children are tried first
+    and then the child with the best value is chosen.
+    To reuse the tree over turns, use ThunderSession
+    in the same way as MctsSession.
+
+    Parameters
+    ----------
+    Subclass inheriting from BaseAlternateState
+        state
+    int
+        playout_number
+        Number of iterations. 0 means no limit.
+    int
+        time_limit
+        Time limit in milliseconds. 0 means no limit.
+    float
+        score_scale
+    int
+        expand_threshold
+        Number of visits before a node is expanded.
+    int
+        node_limit
+    Optional[int]
+        seed
+        Seed of the random generator. The same seed gives the same result.
+        None draws a new seed on every call.
+
+    Returns
+    -------
+    int
+        Action of the player to move
+    """
+    return _thun.thunderSearchAction(state, playout_number, time_limit,
+                                     score_scale, expand_threshold,
+                                     node_limit, seed)
+
+ParallelMode = _thun.ParallelMode
+
+
+def parallel_mcts_action(state: BaseAlternateState, playout_number: int,
+                         time_limit: int = 0, threads: int = 1,
+                         mode: ParallelMode = ParallelMode.Tree,
+                         c: float = 1.0, virtual_loss: int = 1,
+                         expand_threshold: int = 10,
+                         node_limit: int = 100000,
+                         seed: Optional[int] = None) -> int:
+    """Decide action by Monte Carlo tree search on several threads.
+
+    ParallelMode.Tree grows one shared tree.
+    Threads descending through a node add virtual_loss to it
+    so that other threads are pushed to different branches.
+    ParallelMode.Root grows one tree per thread
+    and sums the visit counts of the root children at the end.
+    The GIL is released while searching,
+    but every call into a Python state acquires it again,
+    so a state implemented in Python gains little from threads.
+
+    Parameters
+    ----------
+    Subclass inheriting from BaseAlternateState
+        state
+    int
+        playout_number
+        Number of playouts over all threads. 0 means no limit.
+    int
+        time_limit
+        Time limit in milliseconds. 0 means no limit.
+    int
+        threads
+    ParallelMode
+        mode
+    float
+        c
+        Exploration constant of UCB1.
+    int
+        virtual_loss
+        Losses added to a node while a thread is below it.
+        Used only by ParallelMode.Tree.
+    int
+        expand_threshold
+        Number of visits before a node is expanded.
+    int
+        node_limit
+        Number of nodes over all threads.
+    Optional[int]
+        seed
+        Each thread uses its own random stream split from seed.
+        ParallelMode.Tree with several threads is not reproducible,
+        because the shared tree depends on the timing of the threads.
+        None draws a new seed on every call.
+
+    Returns
+    -------
+    int
+        Action of the player to move
+    """
+    return _thun.parallelMctsAction(state, playout_number, time_limit,
+                                    threads, mode, c, virtual_loss,
+                                    expand_threshold, node_limit, seed)
+
+
+def duct_action(state: BaseSimultaneousState, player_id: int,
+                playout_number: int, time_limit: int = 0, c: float = 1.0,
+                expand_threshold: int = 10, node_limit: int = 100000,
+                seed: Optional[int] = None) -> int:
+    """Decide action of a player by decoupled UCT.
+
+    At each node, both players choose their actions by UCB1
+    looking only at their own statistics.
+
+    Parameters
+    ----------
+    Subclass inheriting from BaseSimultaneousState
+        state
+    int
+        player_id
+        0 or 1
+    int
+        playout_number
+        Number of playouts. 0 means no limit.
+    int
+        time_limit
+        Time limit in milliseconds. 0 means no limit.
+    float
+        c
+        Exploration constant of UCB1.
+    int
+        expand_threshold
+        Number of visits before a node is expanded.
+    int
+        node_limit
+        Maximum number of nodes. The per-player statistics take at most
+        2 * node_limit more entries and are allocated up front with the pool.
+    Optional[int]
+        seed
+        Seed of the random generator. The same seed gives the same result.
+        None draws a new seed on every call.
+
+    Returns
+    -------
+    int
+        Action of the player
     """
-    return _thun.beamSearchAction(state, beam_width)
+    return _thun.ductAction(state, player_id, playout_number, time_limit, c,
+                            expand_threshold, node_limit, seed)
 
 
 def show_task(state: BaseContextualState, actions: List[int]) -> None: